@@ -0,0 +1,279 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include "steganography.h"
+#include "LSB_header.h"
+#include "LSB_crc.h"
+#include "LSB_methods.h"
+
+
+namespace steg {
+
+
+    // The on-disk form of the cache:
+    //
+    //      magic       4 bytes   'S' 'G' 'L' 'C'
+    //      version     1 byte    LOCATION_FILE_VERSION
+    //      lists       for every list: method (1 byte), width and height
+    //                  (4 bytes each), number of locations (8 bytes) and
+    //                  the locations (8 bytes each), all little endian
+    //      crc         4 bytes   CRC-32C of all the bytes above
+    //
+    // The least recently used list is written first, so loading the file
+    // gives back the same order.
+
+#define LOCATION_FILE_VERSION 1
+#define LOCATION_FILE_HEADER 5
+
+    struct location_key {
+        Method method;
+        int width;
+        int height;
+
+        bool operator<(const location_key &other) const {
+            if (method != other.method)
+                return method < other.method;
+            if (width != other.width)
+                return width < other.width;
+            return height < other.height;
+        }
+    };
+
+    // Least recently used lists are dropped first once the lists take
+    // more memory than the limit. The lists are shared, so a dropped list
+    // stays alive for as long as some encode/decode still uses it.
+    class location_cache {
+    public:
+        location_cache() : limit(LOCATION_CACHE_LIMIT), used(0) {}
+
+        location_list find(const location_key &key);
+
+        void insert(const location_key &key, const location_list &locations);
+
+        void set_limit(uint64_t bytes);
+
+        // the lists from the least recently used one
+        std::vector<std::pair<location_key, location_list>> lists();
+
+    private:
+        typedef std::list<std::pair<location_key, location_list>> usage_list;
+
+        std::mutex mutex;
+        usage_list usage;    // the most recently used list first
+        std::map<location_key, usage_list::iterator> entries;
+        uint64_t limit;
+        uint64_t used;
+
+        void shrink();
+    };
+
+    static location_cache &cache();
+
+    static uint64_t list_bytes(const location_list &locations);
+
+    static void put_little_endian(std::vector<uint8_t> &bytes, uint64_t value, int count);
+
+    static uint64_t get_little_endian(const uint8_t *bytes, int count);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    location_list list_locations(int width, int height, Method method) {
+        location_key key{method, width, height};
+        location_list locations = cache().find(key);
+        if (locations)
+            return locations;
+
+        // computed without holding the lock, if another thread computes
+        // the same list meanwhile one of them is simply dropped
+        locations = std::make_shared<const std::vector<int64_t>>(
+                compute_locations(width, height, method));
+        cache().insert(key, locations);
+        return locations;
+    }
+
+    location_list list_locations(const PixelView &image, Method method) {
+        return list_locations(image.width, image.height, method);
+    }
+
+    location_list cached_locations(int width, int height, Method method) {
+        return cache().find(location_key{method, width, height});
+    }
+
+    void StegCoding::set_location_cache_limit(uint64_t bytes) {
+        cache().set_limit(bytes);
+    }
+
+    bool StegCoding::save_location_cache(const std::string &file) {
+        std::vector<uint8_t> bytes = {'S', 'G', 'L', 'C', LOCATION_FILE_VERSION};
+        for (const auto &list : cache().lists()) {
+            bytes.push_back((uint8_t) list.first.method);
+            put_little_endian(bytes, (uint64_t) list.first.width, 4);
+            put_little_endian(bytes, (uint64_t) list.first.height, 4);
+            put_little_endian(bytes, list.second->size(), 8);
+            for (int64_t location : *list.second)
+                put_little_endian(bytes, (uint64_t) location, 8);
+        }
+
+        uint8_t crc[CRC32C_SIZE];
+        store_crc32c(crc32c(0, bytes.data(), bytes.size()), crc);
+        bytes.insert(bytes.end(), crc, crc + CRC32C_SIZE);
+
+        std::ofstream out(file.c_str(), std::ios::binary);
+        out.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+        return (bool) out;
+    }
+
+    bool StegCoding::load_location_cache(const std::string &file) {
+        std::ifstream in(file.c_str(), std::ios::binary);
+        if (!in)
+            return false;
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)),
+                                   std::istreambuf_iterator<char>());
+
+        // the whole file is checked before any of the lists is used
+        if (bytes.size() < LOCATION_FILE_HEADER + CRC32C_SIZE ||
+            bytes[0] != 'S' || bytes[1] != 'G' || bytes[2] != 'L' || bytes[3] != 'C' ||
+            bytes[4] != LOCATION_FILE_VERSION)
+            return false;
+        size_t end = bytes.size() - CRC32C_SIZE;
+        if (load_crc32c(&bytes[end]) != crc32c(0, bytes.data(), end))
+            return false;
+
+        std::vector<std::pair<location_key, location_list>> lists;
+        const size_t list_header = 1 + 4 + 4 + 8;
+        for (size_t pos = LOCATION_FILE_HEADER; pos < end;) {
+            if (end - pos < list_header)
+                return false;
+            Method method = (Method) bytes[pos];
+            uint64_t width = get_little_endian(&bytes[pos + 1], 4);
+            uint64_t height = get_little_endian(&bytes[pos + 5], 4);
+            uint64_t count = get_little_endian(&bytes[pos + 9], 8);
+            pos += list_header;
+
+            // only the prime method keeps a list of its locations
+            if (method != Method::LSB_PRIME)
+                return false;
+            if (width > INT32_MAX || height > INT32_MAX || count > (end - pos) / 8)
+                return false;
+
+            std::vector<int64_t> locations(count);
+            for (uint64_t i = 0; i < count; i++, pos += 8) {
+                locations[i] = (int64_t) get_little_endian(&bytes[pos], 8);
+                if (locations[i] < 0 || (uint64_t) locations[i] >= width * height)
+                    return false;
+            }
+            lists.emplace_back(location_key{method, (int) width, (int) height},
+                               std::make_shared<const std::vector<int64_t>>(std::move(locations)));
+        }
+
+        for (const auto &list : lists)
+            cache().insert(list.first, list.second);
+        return true;
+    }
+
+
+    location_list location_cache::find(const location_key &key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(key);
+        if (found == entries.end())
+            return location_list();
+
+        // move the list to the front, as the most recently used one
+        usage.splice(usage.begin(), usage, found->second);
+        return found->second->second;
+    }
+
+    void location_cache::insert(const location_key &key, const location_list &locations) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            usage.splice(usage.begin(), usage, found->second);
+            return;
+        }
+
+        // a list larger than the whole cache is not kept at all
+        uint64_t bytes = list_bytes(locations);
+        if (bytes > limit)
+            return;
+
+        usage.emplace_front(key, locations);
+        entries[key] = usage.begin();
+        used += bytes;
+        shrink();
+    }
+
+    void location_cache::set_limit(uint64_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        limit = bytes;
+        shrink();
+    }
+
+    std::vector<std::pair<location_key, location_list>> location_cache::lists() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return std::vector<std::pair<location_key, location_list>>(usage.rbegin(), usage.rend());
+    }
+
+    void location_cache::shrink() {
+        while (used > limit) {
+            used -= list_bytes(usage.back().second);
+            entries.erase(usage.back().first);
+            usage.pop_back();
+        }
+    }
+
+    static location_cache &cache() {
+        // constructed on the first use, which is thread-safe in C++11
+        static location_cache locations;
+        return locations;
+    }
+
+    static uint64_t list_bytes(const location_list &locations) {
+        return locations->size() * sizeof(int64_t);
+    }
+
+    static void put_little_endian(std::vector<uint8_t> &bytes, uint64_t value, int count) {
+        for (int i = 0; i < count; i++, value >>= BIT_TO_BYTE)
+            bytes.push_back(value & 0xFFU);
+    }
+
+    static uint64_t get_little_endian(const uint8_t *bytes, int count) {
+        uint64_t value = 0;
+        for (int i = count - 1; i >= 0; i--)
+            value = (value << BIT_TO_BYTE) | bytes[i];
+        return value;
+    }
+
+}
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include "LSB_crc.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+
+namespace steg {
+
+    // reversed polynomial of CRC-32C
+    static const uint32_t CRC32C_POLY = 0x82F63B78U;
+
+    static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec);
+
+    static void gf2_matrix_square(uint32_t *square, const uint32_t *mat);
+
+
+#if defined(__SSE4_2__)
+
+    uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t size) {
+        crc = ~crc;
+#if defined(__x86_64__)
+        uint64_t crc64 = crc;
+        for (; size >= 8; data += 8, size -= 8) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+        crc = (uint32_t) crc64;
+#endif
+        for (; size >= 4; data += 4, size -= 4) {
+            uint32_t word;
+            std::memcpy(&word, data, sizeof(word));
+            crc = _mm_crc32_u32(crc, word);
+        }
+        for (; size > 0; data++, size--)
+            crc = _mm_crc32_u8(crc, *data);
+        return ~crc;
+    }
+
+#else
+
+    struct crc32c_table {
+        uint32_t entries[256];
+
+        crc32c_table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; bit++)
+                    crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+                entries[i] = crc;
+            }
+        }
+    };
+
+    uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t size) {
+        static const crc32c_table table;
+
+        crc = ~crc;
+        for (; size > 0; data++, size--)
+            crc = table.entries[(crc ^ *data) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+#endif
+
+
+    // Same as zlib's crc32_combine: appending size2 zero bytes to the
+    // first piece is a linear operation on its CRC, which is applied by
+    // squaring the matrix of a single zero bit log(size2) times.
+    uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t size2) {
+        uint32_t even[32];  // even powers of two zero bits
+        uint32_t odd[32];   // odd powers of two zero bits
+
+        if (size2 == 0)
+            return crc1;
+
+        // operator for a single zero bit
+        odd[0] = CRC32C_POLY;
+        uint32_t row = 1;
+        for (int n = 1; n < 32; n++) {
+            odd[n] = row;
+            row <<= 1;
+        }
+
+        gf2_matrix_square(even, odd);  // two zero bits
+        gf2_matrix_square(odd, even);  // four zero bits
+
+        // the first square gives a whole zero byte
+        do {
+            gf2_matrix_square(even, odd);
+            if (size2 & 1)
+                crc1 = gf2_matrix_times(even, crc1);
+            size2 >>= 1;
+            if (size2 == 0)
+                break;
+
+            gf2_matrix_square(odd, even);
+            if (size2 & 1)
+                crc1 = gf2_matrix_times(odd, crc1);
+            size2 >>= 1;
+        } while (size2 != 0);
+
+        return crc1 ^ crc2;
+    }
+
+    static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+        uint32_t sum = 0;
+        for (; vec; vec >>= 1, mat++) {
+            if (vec & 1)
+                sum ^= *mat;
+        }
+        return sum;
+    }
+
+    static void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+        for (int n = 0; n < 32; n++)
+            square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+
+}
@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_CRC_H
+#define IMAGE_STEGANOGRPAHY_LSB_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace steg {
+
+    // CRC-32C (Castagnoli) of the message, used as the optional checksum
+    // of the payload. Works like zlib's crc32: start with 0 and pass the
+    // returned value to the next call to continue over more data, so it
+    // can be computed piece by piece as the message is encoded/decoded.
+    //
+    // Uses the SSE4.2 crc32 instruction when the compiler targets it
+    // (e.g. -msse4.2 or -march=native), a lookup table otherwise.
+    uint32_t crc32c(uint32_t crc, const uint8_t *data, size_t size);
+
+    // CRC-32C of two pieces of data one after another, given the CRC-32C
+    // of both of them and the length of the second one, so the pieces
+    // can be checked separately (e.g. on different threads).
+    uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_CRC_H
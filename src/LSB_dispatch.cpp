@@ -0,0 +1,189 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <assert.h>
+#include "steganography.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_png.h"
+#include "LSB_primes.h"
+
+
+namespace steg {
+
+
+    void StegCoding::encode(const PixelView &image,
+                            const std::string &message,
+                            Method method,
+                            const StegOptions &options) {
+        encode_message(image, message, method, options);
+    }
+
+    void StegCoding::encode(const PixelView &image,
+                            const uint8_t *payload,
+                            size_t size,
+                            Method method,
+                            const StegOptions &options) {
+        encode_message(image, message_bytes(payload, size), method, options);
+    }
+
+    std::string StegCoding::decode(const PixelView &image,
+                                   Method method,
+                                   const StegOptions &options) {
+        std::string message;
+        message_output output(message);
+        if (!decode_message(image, method, options, output))
+            message.clear();
+        return message;
+    }
+
+    uint64_t StegCoding::decode(const PixelView &image,
+                                uint8_t *payload,
+                                size_t size,
+                                Method method,
+                                const StegOptions &options) {
+        // a message longer than the memory is not decoded, but its
+        // length is still given
+        message_output output(payload, size);
+        if (decode_message(image, method, options, output))
+            return output.length();
+        return output.length() > size ? output.length() : 0;
+    }
+
+    void encode_message(const PixelView &image,
+                        const message_bytes &message,
+                        Method method,
+                        const StegOptions &options) {
+        assert(options.bits >= 1 && options.bits <= MAX_BITS);
+
+        // the image might not have the channels asked for
+        if (!valid_channels(image, options.channels))
+            return;
+        switch (method) {
+            case Method::LSB:
+                encode_sequential(image, message, options);
+                break;
+            case Method::LSB_ODD:
+                encode_lane(image, message, 2, 1, options);
+                break;
+            case Method::LSB_EVEN:
+                encode_lane(image, message, 2, 0, options);
+                break;
+            case Method::LSB_MAX:
+            case Method::LSB_MIN:
+                encode_min_max(image, message, method, options);
+                break;
+            case Method::LSB_PRIME:
+                encode_prime(image, message, options);
+                break;
+            case Method::LSB_SPIRAL:
+                encode_spiral(image, message, options);
+                break;
+            case Method::LSB_MAGIC_SQ:
+                encode_magic_square(image, message, options);
+                break;
+        }
+    }
+
+    bool decode_message(const PixelView &image,
+                        Method method,
+                        const StegOptions &options,
+                        message_output &output) {
+        assert(options.bits >= 1 && options.bits <= MAX_BITS);
+
+        if (!valid_channels(image, options.channels))
+            return false;
+        switch (method) {
+            case Method::LSB:
+                return decode_sequential(image, options, output);
+            case Method::LSB_ODD:
+                return decode_lane(image, 2, 1, options, output);
+            case Method::LSB_EVEN:
+                return decode_lane(image, 2, 0, options, output);
+            case Method::LSB_MAX:
+            case Method::LSB_MIN:
+                return decode_min_max(image, method, options, output);
+            case Method::LSB_PRIME:
+                return decode_prime(image, options, output);
+            case Method::LSB_SPIRAL:
+                return decode_spiral(image, options, output);
+            case Method::LSB_MAGIC_SQ:
+                return decode_magic_square(image, options, output);
+        }
+        assert(false);
+        return false;
+    }
+
+    uint64_t StegCoding::capacity(const PixelView &image,
+                                  Method method,
+                                  const StegOptions &options) {
+        return image_capacity(image.width, image.height, image.channels, method, options);
+    }
+
+    uint64_t StegCoding::capacity(const std::string &name,
+                                  Method method,
+                                  const StegOptions &options) {
+        // only the size is needed, which the PNG header gives
+        int width, height, channels;
+        if (!png_file_info(name, width, height, channels))
+            return 0;
+        return image_capacity(width, height, channels, method, options);
+    }
+
+    uint64_t image_capacity(int width, int height, int channels,
+                            Method method, const StegOptions &options) {
+        if (channels >= 32 || (options.channels >> channels) != 0)
+            return 0;
+
+        uint64_t total_pixels = (uint64_t) width * height;
+        switch (method) {
+            case Method::LSB:
+            case Method::LSB_SPIRAL:
+            case Method::LSB_MAGIC_SQ:
+                // the spiral and the magic square use every pixel
+                return planes_capacity(total_pixels, options);
+            case Method::LSB_ODD:
+                return planes_capacity(total_pixels / 2, options);
+            case Method::LSB_EVEN:
+                return planes_capacity((total_pixels + 1) / 2, options);
+            case Method::LSB_MAX:
+            case Method::LSB_MIN:
+                // the same number of pixels in each row
+                return planes_capacity(min_max_samples(width, height, options),
+                                       min_max_options(options));
+            case Method::LSB_PRIME: {
+                // only the number of the primes is needed, the list is not
+                // computed (nor cached) unless it is there already
+                location_list cached = cached_locations(width, height, method);
+                uint64_t count = cached ? cached->size()
+                                        : (uint64_t) prime_count(total_pixels, options.threads);
+                return planes_capacity(count, options);
+            }
+        }
+        assert(false);
+        return 0;
+    }
+
+}
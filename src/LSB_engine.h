@@ -0,0 +1,590 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_ENGINE_H
+#define IMAGE_STEGANOGRPAHY_LSB_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <assert.h>
+#include "steganography.h"
+#include "LSB_header.h"
+#include "LSB_crc.h"
+
+namespace steg {
+
+    // Every method encodes the same stream of bits: the header holding
+    // the length of the message (see LSB_header.h) followed by the bits
+    // of the message, each byte most significant bit first. The methods
+    // only differ in the samples of the image the stream is stored in,
+    // which are given one by one, in the order used by the method, by a
+    // cursor:
+    //
+    //      struct cursor {
+    //          void restart(int channel);
+    //          unsigned char &next();
+    //      };
+    //
+    // restart moves the cursor to the first sample of the given channel,
+    // the message is spread over the channels of the options one channel
+    // after another by plane_cursor.
+    //
+    // Each sample holds BITS (1 to 4) bits of the stream in its least
+    // significant bits, the first of them in the highest of those bits.
+    // All the functions are templates on BITS, so the loops are compiled
+    // separately for every number of bits.
+
+#define MAX_BITS 4
+
+    // The checksum is computed over pieces of the message of this size
+    // right after they are decoded, while they are still in the cache,
+    // instead of going over the whole message again.
+#define STREAM_CHUNK 4096
+
+    // The bytes of a message to encode, which are not owned or copied,
+    // so both strings and binary payloads (e.g. with NUL bytes) are
+    // encoded straight from the memory of the caller.
+    struct message_bytes {
+        const uint8_t *data;
+        uint64_t size;
+
+        message_bytes(const std::string &message)
+                : data(reinterpret_cast<const uint8_t *>(message.data())),
+                  size(message.size()) {}
+
+        message_bytes(const uint8_t *data, uint64_t size)
+                : data(data), size(size) {}
+    };
+
+    // Where a message is decoded to, either a string or the memory of
+    // the caller. reserve(length) is called once the header gives the
+    // length and returns the memory for the whole message, so the message
+    // is written in place without ever growing; nullptr (the message does
+    // not fit into the memory of the caller) stops the decoding.
+    class message_output {
+    public:
+        explicit message_output(std::string &message)
+                : message(&message), data(nullptr), capacity(0), size(0) {}
+
+        message_output(uint8_t *data, uint64_t capacity)
+                : message(nullptr), data(data), capacity(capacity), size(0) {}
+
+        uint8_t *reserve(uint64_t length) {
+            size = length;
+            if (message) {
+                message->resize(length);
+                return reinterpret_cast<uint8_t *>(&(*message)[0]);
+            }
+            return length <= capacity ? data : nullptr;
+        }
+
+        // length of the message given to reserve
+        uint64_t length() const {
+            return size;
+        }
+
+    private:
+        std::string *message;
+        uint8_t *data;
+        uint64_t capacity;
+        uint64_t size;
+    };
+
+    // Gives the bits of the stream BITS at a time, the stream being made
+    // of the header bytes, the payload bytes and the trailer bytes, zero
+    // padded at the end.
+    template<int BITS>
+    class bit_source {
+    public:
+        bit_source(const uint8_t *header, size_t header_size,
+                   const uint8_t *payload, size_t payload_size,
+                   const uint8_t *trailer, size_t trailer_size)
+                : header(header), header_size(header_size),
+                  payload(payload), payload_size(payload_size),
+                  trailer(trailer), trailer_size(trailer_size),
+                  pos(0), acc(0), count(0) {}
+
+        unsigned next() {
+            if (count < BITS) {
+                acc = (acc << BIT_TO_BYTE) | byte_at(pos++);
+                count += BIT_TO_BYTE;
+            }
+            count -= BITS;
+            return (acc >> count) & ((1U << BITS) - 1);
+        }
+
+    private:
+        const uint8_t *header;
+        size_t header_size;
+        const uint8_t *payload;
+        size_t payload_size;
+        const uint8_t *trailer;
+        size_t trailer_size;
+        size_t pos;
+        uint32_t acc;
+        int count;
+
+        uint8_t byte_at(size_t i) const {
+            if (i < header_size)
+                return header[i];
+            i -= header_size;
+            if (i < payload_size)
+                return payload[i];
+            i -= payload_size;
+            return i < trailer_size ? trailer[i] : 0;
+        }
+    };
+
+    // Collects BITS bits at a time into the bytes of the output, the output
+    // can be switched (e.g. from the header to the message) without losing
+    // the bits which do not make a whole byte yet.
+    template<int BITS>
+    class bit_sink {
+    public:
+        bit_sink(uint8_t *bytes, size_t size)
+                : bytes(bytes), size(size), pos(0), acc(0), count(0) {}
+
+        void push(unsigned value) {
+            acc = (acc << BITS) | value;
+            count += BITS;
+            if (count >= BIT_TO_BYTE) {
+                count -= BIT_TO_BYTE;
+                bytes[pos++] = (uint8_t) (acc >> count);
+            }
+        }
+
+        bool full() const {
+            return pos == size;
+        }
+
+        void reset(uint8_t *new_bytes, size_t new_size) {
+            bytes = new_bytes;
+            size = new_size;
+            pos = 0;
+        }
+
+    private:
+        uint8_t *bytes;
+        size_t size;
+        size_t pos;
+        uint32_t acc;
+        int count;
+    };
+
+    // The bits of the stream (header, payload and trailer bytes) by
+    // their position, for the encoders which do not visit the samples
+    // in the order of the stream (e.g. the rows of all the channels at
+    // once).
+    class stream_bits {
+    public:
+        stream_bits(const uint8_t *header, size_t header_size,
+                    const uint8_t *payload, size_t payload_size,
+                    const uint8_t *trailer, size_t trailer_size)
+                : header(header), header_size(header_size),
+                  payload(payload), payload_size(payload_size),
+                  trailer(trailer), trailer_size(trailer_size) {}
+
+        // number of bits in the stream
+        uint64_t size() const {
+            return (uint64_t) (header_size + payload_size + trailer_size) * BIT_TO_BYTE;
+        }
+
+        // count (at most 8) bits starting at the given bit, the first of
+        // them in the highest bit, bits past the end of the stream are 0
+        unsigned get(uint64_t bit, int count) const {
+            uint64_t byte = bit / BIT_TO_BYTE;
+            unsigned value = (unsigned) byte_at(byte) << BIT_TO_BYTE | byte_at(byte + 1);
+            int shift = 2 * BIT_TO_BYTE - (int) (bit % BIT_TO_BYTE) - count;
+            return (value >> shift) & ((1U << count) - 1);
+        }
+
+    private:
+        const uint8_t *header;
+        size_t header_size;
+        const uint8_t *payload;
+        size_t payload_size;
+        const uint8_t *trailer;
+        size_t trailer_size;
+
+        uint8_t byte_at(uint64_t i) const {
+            if (i < header_size)
+                return header[i];
+            i -= header_size;
+            if (i < payload_size)
+                return payload[i];
+            i -= payload_size;
+            return i < trailer_size ? trailer[i] : 0;
+        }
+    };
+
+    // Writes the bits of the stream held by the sample with the given
+    // number (holding bits bits), the same way encode_stream does.
+    inline void put_stream_sample(const stream_bits &stream, uint64_t number,
+                                  int bits, unsigned char &sample) {
+        uint64_t bit = number * bits;
+        if (bit >= stream.size())
+            return;
+
+        // the last sample might hold only a part of the bits, the
+        // rest of its bits are left untouched
+        uint64_t rest = stream.size() - bit;
+        unsigned mask = (1U << bits) - 1;
+        if (rest < (uint64_t) bits)
+            mask &= ~((1U << (bits - rest)) - 1);
+        sample = (sample & ~mask) | (stream.get(bit, bits) & mask);
+    }
+
+    // The samples of a channel of the image addressed by the flat 64-bit
+    // number of the pixel (counting the pixels row by row). When the rows
+    // of the view follow each other without gaps, as the CImg planes and
+    // packed interleaved pixels do, the sample is found without dividing
+    // the number into the row and the column. Otherwise (padded or bottom
+    // up rows, e.g. a BMP file) the row is the high part of the number
+    // multiplied by the rounded up reciprocal of the width, which is exact
+    // for all the numbers below 2^63 with 63 + ceil(log2(width)) bits
+    // after the point, so no division is done per sample either.
+    class channel_samples {
+    public:
+        channel_samples(const PixelView &image, int channel)
+                : base(&image(0, 0, channel)), width(image.width),
+                  stride(image.stride), pixel_step(image.pixel_step),
+                  flat(image.height == 1 || image.stride == image.width * image.pixel_step),
+                  reciprocal(0), shift(63) {
+            while (((int64_t) 1 << (shift - 63)) < width)
+                shift++;
+            unsigned __int128 one = (unsigned __int128) 1 << shift;
+            reciprocal = (uint64_t) ((one + width - 1) / width);
+        }
+
+        unsigned char &operator[](int64_t pixel) const {
+            if (flat)
+                return base[pixel * pixel_step];
+            int64_t row = (int64_t) (((unsigned __int128) pixel * reciprocal) >> shift);
+            return base[row * stride + (pixel - row * width) * pixel_step];
+        }
+
+        bool is_flat() const {
+            return flat;
+        }
+
+    private:
+        unsigned char *base;
+        int64_t width;
+        int64_t stride;
+        int64_t pixel_step;
+        bool flat;
+        uint64_t reciprocal;    // 2^shift / width, rounded up
+        int shift;
+    };
+
+    // Cursor over the pixels first, first + step, first + 2 * step, ...
+    // (counting the pixels row by row) of a channel of the image. In flat
+    // views the cursor only moves an offset from the start of the channel,
+    // otherwise it steps over the row ends.
+    class pixel_cursor {
+    public:
+        pixel_cursor(const PixelView &image, uint64_t first, int step)
+                : image(image), first(first), step(step), channel(BLUE),
+                  samples(image, BLUE), offset(0), w(0), h(0) {
+            restart(BLUE);
+        }
+
+        void restart(int new_channel) {
+            channel = new_channel;
+            samples = channel_samples(image, channel);
+            offset = first;
+            w = first % image.width;
+            h = first / image.width;
+        }
+
+        unsigned char &next() {
+            if (samples.is_flat()) {
+                unsigned char &sample = samples[offset];
+                offset += step;
+                return sample;
+            }
+
+            unsigned char &sample = image(w, h, channel);
+            w += step;
+            while (w >= image.width) {
+                w -= image.width;
+                h++;
+            }
+            return sample;
+        }
+
+    private:
+        const PixelView &image;
+        uint64_t first;
+        int step;
+        int channel;
+        channel_samples samples;
+        int64_t offset;
+        int w;
+        int h;
+    };
+
+    // Walks the given number of samples of the cursor in each of the
+    // channels of the mask, in the order of the channels. The samples
+    // of one channel are next to each other in the planar layout, so
+    // the writes stay contiguous.
+    template<typename Cursor>
+    class plane_cursor {
+    public:
+        plane_cursor(Cursor cursor, uint64_t samples, unsigned channels)
+                : cursor(cursor), samples(samples), channels(channels),
+                  channel(-1), left(0) {}
+
+        unsigned char &next() {
+            if (left == 0) {
+                do {
+                    channel++;
+                    assert(channel < 32);
+                } while (!(channels & CHANNEL_MASK(channel)));
+                cursor.restart(channel);
+                left = samples;
+            }
+            left--;
+            return cursor.next();
+        }
+
+    private:
+        Cursor cursor;
+        uint64_t samples;
+        unsigned channels;
+        int channel;
+        uint64_t left;
+    };
+
+    inline int channel_count(unsigned channels) {
+        int count = 0;
+        for (; channels; channels &= channels - 1)
+            count++;
+        return count;
+    }
+
+    // the channel if only a single channel is in the mask, otherwise -1
+    inline int single_channel(unsigned channels) {
+        if (channel_count(channels) != 1)
+            return -1;
+        int channel = 0;
+        while (!(channels & CHANNEL_MASK(channel)))
+            channel++;
+        return channel;
+    }
+
+    // all the channels of the mask are present in the image
+    inline bool valid_channels(const PixelView &image, unsigned channels) {
+        return channels != 0 && image.channels < 32 &&
+               (channels >> image.channels) == 0;
+    }
+
+    // Number of message bytes which fit into the given number of samples
+    // holding bits bits each, after the header with the given flags is
+    // encoded.
+    inline uint64_t stream_capacity(uint64_t samples, int bits, uint8_t flags) {
+        return header_capacity(samples * bits, flags);
+    }
+
+    // the header (and the trailer) with the given flags fit into the
+    // given number of samples holding bits bits each
+    inline bool header_fits(uint64_t samples, int bits, uint8_t flags) {
+        return samples * bits >= (HEADER_MIN_SIZE + trailer_size(flags)) * BIT_TO_BYTE;
+    }
+
+    // Encodes the header and as much of the message as fits into the
+    // given number of samples of the cursor. Nothing is written if not
+    // even the header fits.
+    template<int BITS, typename Cursor>
+    void encode_stream(Cursor cursor, uint64_t samples, const message_bytes &message,
+                       Method method, uint8_t flags) {
+        const unsigned mask = (1U << BITS) - 1;
+        const uint8_t *payload = message.data;
+
+        if (!header_fits(samples, BITS, flags))
+            return;
+
+        uint64_t msg_length = message.size;
+        uint64_t capacity = stream_capacity(samples, BITS, flags);
+        if (msg_length > capacity)
+            msg_length = capacity;
+
+        uint8_t header[HEADER_MAX_SIZE];
+        size_t size = write_header(StegHeader{method, flags, msg_length}, header);
+
+        // the message is only read here, walking the samples costs
+        // much more than computing the checksum beforehand
+        uint8_t trailer[CRC32C_SIZE];
+        if (flags & HEADER_FLAG_CRC32C)
+            store_crc32c(crc32c(0, payload, msg_length), trailer);
+
+        bit_source<BITS> source(header, size, payload, msg_length,
+                                trailer, trailer_size(flags));
+
+        uint64_t bits = (size + msg_length + trailer_size(flags)) * BIT_TO_BYTE;
+        uint64_t used = bits / BITS;
+        for (uint64_t i = 0; i < used; i++) {
+            unsigned char &sample = cursor.next();
+            sample = (sample & ~mask) | source.next();
+        }
+
+        // the last sample might hold only a part of BITS bits, the rest
+        // of its bits are left untouched
+        int rest = bits % BITS;
+        if (rest > 0) {
+            const unsigned keep = (1U << (BITS - rest)) - 1;
+            unsigned char &sample = cursor.next();
+            sample = (sample & (~mask | keep)) | (source.next() & ~keep);
+        }
+    }
+
+    // Decodes the message encoded by encode_stream from the cursor into
+    // the output, reading at most the given number of samples. Returns
+    // false as soon as the header turns out not to be valid, if the
+    // message does not fit into the output or if the checksum of the
+    // message does not match.
+    template<int BITS, typename Cursor>
+    bool decode_stream(Cursor cursor, uint64_t samples, Method method,
+                       message_output &output) {
+        const unsigned mask = (1U << BITS) - 1;
+
+        uint8_t byte;
+        uint64_t read = 0;
+        bit_sink<BITS> sink(&byte, 1);
+        header_reader reader(method);
+        header_reader::State state = header_reader::MORE;
+        while (state == header_reader::MORE) {
+            while (!sink.full()) {
+                if (read++ == samples)
+                    return false;
+                sink.push(cursor.next() & mask);
+            }
+            state = reader.push(byte);
+            sink.reset(&byte, 1);
+        }
+        if (state == header_reader::INVALID)
+            return false;
+
+        // a length longer than the image is not a valid header either,
+        // which also keeps the reading below within the samples
+        uint8_t flags = reader.header().flags;
+        uint64_t msg_length = reader.header().length;
+        if (!message_fits(samples * BITS, reader.size(), msg_length, flags))
+            return false;
+
+        uint8_t *payload = output.reserve(msg_length);
+        if (!payload)
+            return false;
+        uint32_t crc = 0;
+        for (uint64_t done = 0; done < msg_length; done += STREAM_CHUNK) {
+            size_t chunk = msg_length - done < STREAM_CHUNK ? msg_length - done : STREAM_CHUNK;
+            sink.reset(payload + done, chunk);
+            while (!sink.full())
+                sink.push(cursor.next() & mask);
+            if (flags & HEADER_FLAG_CRC32C)
+                crc = crc32c(crc, payload + done, chunk);
+        }
+
+        if (flags & HEADER_FLAG_CRC32C) {
+            uint8_t trailer[CRC32C_SIZE];
+            sink.reset(trailer, sizeof(trailer));
+            while (!sink.full())
+                sink.push(cursor.next() & mask);
+            if (load_crc32c(trailer) != crc)
+                return false;
+        }
+        return true;
+    }
+
+    // Same as above with the number of bits chosen at runtime.
+    template<typename Cursor>
+    void encode_stream(int bits, Cursor cursor, uint64_t samples,
+                       const message_bytes &message, Method method, uint8_t flags) {
+        switch (bits) {
+            case 1:
+                encode_stream<1>(cursor, samples, message, method, flags);
+                break;
+            case 2:
+                encode_stream<2>(cursor, samples, message, method, flags);
+                break;
+            case 3:
+                encode_stream<3>(cursor, samples, message, method, flags);
+                break;
+            case 4:
+                encode_stream<4>(cursor, samples, message, method, flags);
+                break;
+            default:
+                assert(false);
+        }
+    }
+
+    template<typename Cursor>
+    bool decode_stream(int bits, Cursor cursor, uint64_t samples, Method method,
+                       message_output &output) {
+        switch (bits) {
+            case 1:
+                return decode_stream<1>(cursor, samples, method, output);
+            case 2:
+                return decode_stream<2>(cursor, samples, method, output);
+            case 3:
+                return decode_stream<3>(cursor, samples, method, output);
+            case 4:
+                return decode_stream<4>(cursor, samples, method, output);
+            default:
+                assert(false);
+                return false;
+        }
+    }
+
+    // Encodes the message into the given number of samples of the cursor
+    // in every channel of the options, with the bits of the options.
+    template<typename Cursor>
+    void encode_planes(Cursor cursor, uint64_t samples, const message_bytes &message,
+                       Method method, const StegOptions &options) {
+        encode_stream(options.bits,
+                      plane_cursor<Cursor>(cursor, samples, options.channels),
+                      samples * channel_count(options.channels), message,
+                      method, header_flags(options));
+    }
+
+    template<typename Cursor>
+    bool decode_planes(Cursor cursor, uint64_t samples, Method method,
+                       const StegOptions &options, message_output &output) {
+        return decode_stream(options.bits,
+                             plane_cursor<Cursor>(cursor, samples, options.channels),
+                             samples * channel_count(options.channels), method, output);
+    }
+
+    // number of message bytes which fit into the given number of samples
+    // in every channel of the options
+    inline uint64_t planes_capacity(uint64_t samples, const StegOptions &options) {
+        return stream_capacity(samples * channel_count(options.channels),
+                               options.bits, header_flags(options));
+    }
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_ENGINE_H
@@ -0,0 +1,129 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <cstddef>
+#include <cstdint>
+#include "steganography.h"
+#include "LSB_header.h"
+
+
+namespace steg {
+
+
+    static uint8_t crc8_update(uint8_t crc, uint8_t byte);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    size_t write_header(const StegHeader &header, uint8_t *bytes) {
+        size_t size = 0;
+        bytes[size++] = HEADER_MAGIC_0;
+        bytes[size++] = HEADER_MAGIC_1;
+        bytes[size++] = (uint8_t) (HEADER_VERSION << 4 | (int) header.method);
+        bytes[size++] = header.flags;
+
+        uint64_t length = header.length;
+        while (length >= 0x80) {
+            bytes[size++] = (uint8_t) (length | 0x80);
+            length >>= 7;
+        }
+        bytes[size++] = (uint8_t) length;
+
+        uint8_t crc = 0;
+        for (size_t i = 0; i < size; i++)
+            crc = crc8_update(crc, bytes[i]);
+        bytes[size++] = crc;
+        return size;
+    }
+
+    size_t header_size(uint64_t length) {
+        size_t size = HEADER_MIN_SIZE;
+        for (; length >= 0x80; length >>= 7)
+            size++;
+        return size;
+    }
+
+    uint64_t header_capacity(uint64_t bits, uint8_t flags) {
+        uint64_t bytes = bits / BIT_TO_BYTE;
+        if (bytes < HEADER_MIN_SIZE + trailer_size(flags))
+            return 0;
+        bytes -= trailer_size(flags);
+
+        // a longer message might need a longer header, at most a few
+        // steps are needed to find the size which fits
+        uint64_t capacity = bytes - HEADER_MIN_SIZE;
+        while (capacity > 0 && header_size(capacity) + capacity > bytes)
+            capacity--;
+        return capacity;
+    }
+
+
+    header_reader::header_reader(Method method)
+            : result{method, 0, 0}, count(0), shift(0),
+              length_done(false), crc(0) {}
+
+    header_reader::State header_reader::push(uint8_t byte) {
+        size_t i = count++;
+        if (length_done)  // the last byte is the crc
+            return byte == crc ? DONE : INVALID;
+        crc = crc8_update(crc, byte);
+
+        switch (i) {
+            case 0:
+                return byte == HEADER_MAGIC_0 ? MORE : INVALID;
+            case 1:
+                return byte == HEADER_MAGIC_1 ? MORE : INVALID;
+            case 2:
+                return byte == (HEADER_VERSION << 4 | (int) result.method) ? MORE : INVALID;
+            case 3:
+                result.flags = byte;
+                return (byte & ~HEADER_FLAGS) == 0 ? MORE : INVALID;
+            default:
+                // the length can not be longer than 64 bits
+                if (shift > 63 || (shift == 63 && (byte & 0x7F) > 1))
+                    return INVALID;
+                result.length |= (uint64_t) (byte & 0x7F) << shift;
+                shift += 7;
+                length_done = !(byte & 0x80);
+                // only the shortest form of the length is valid, so the
+                // header is never longer than header_size(length)
+                if (length_done && byte == 0 && i > 4)
+                    return INVALID;
+                return MORE;
+        }
+    }
+
+
+    // CRC-8 with the polynomial x^8 + x^2 + x + 1
+    static uint8_t crc8_update(uint8_t crc, uint8_t byte) {
+        crc ^= byte;
+        for (int i = 0; i < BIT_TO_BYTE; i++)
+            crc = (crc & 0x80) ? (uint8_t) ((crc << 1) ^ 0x07) : (uint8_t) (crc << 1);
+        return crc;
+    }
+
+}
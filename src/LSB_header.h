@@ -0,0 +1,143 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_HEADER_H
+#define IMAGE_STEGANOGRPAHY_LSB_HEADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "steganography.h"
+
+namespace steg {
+
+    // The header stored in front of every message:
+    //
+    //      magic           2 bytes   'S' 'G'
+    //      version/method  1 byte    HEADER_VERSION << 4 | method
+    //      flags           1 byte    HEADER_FLAG_xxx
+    //      length          1 to 10 bytes, varint (7 bits per byte,
+    //                      least significant group first, in the
+    //                      shortest form)
+    //      crc             1 byte    CRC-8 of all the bytes above
+    //
+    // The magic is the first thing read, so an image without a message
+    // is rejected after 16 bits in nearly all the cases, the rest of the
+    // header is checked by the crc before the length is trusted.
+    //
+    // With HEADER_FLAG_CRC32C the message is followed by its CRC-32C
+    // (4 bytes, most significant byte first).
+
+#define HEADER_MAGIC_0 'S'
+#define HEADER_MAGIC_1 'G'
+#define HEADER_VERSION 1
+#define HEADER_MIN_SIZE 6
+#define HEADER_MAX_SIZE 15
+
+#define HEADER_FLAG_CRC32C 0x01
+#define HEADER_FLAGS HEADER_FLAG_CRC32C
+#define CRC32C_SIZE 4
+
+    struct StegHeader {
+        Method method;
+        uint8_t flags;
+        uint64_t length;
+    };
+
+    // Writes the header into bytes (at least HEADER_MAX_SIZE long),
+    // returns the number of bytes written.
+    size_t write_header(const StegHeader &header, uint8_t *bytes);
+
+    // size of the header for a message of the given length
+    size_t header_size(uint64_t length);
+
+    // header flags for the options
+    inline uint8_t header_flags(const StegOptions &options) {
+        return options.checksum ? HEADER_FLAG_CRC32C : 0;
+    }
+
+    // number of bytes stored after the message
+    inline size_t trailer_size(uint8_t flags) {
+        return (flags & HEADER_FLAG_CRC32C) ? CRC32C_SIZE : 0;
+    }
+
+    // the checksum after the message, most significant byte first
+    inline void store_crc32c(uint32_t crc, uint8_t *bytes) {
+        for (int i = CRC32C_SIZE - 1; i >= 0; i--, crc >>= BIT_TO_BYTE)
+            bytes[i] = crc & 0xFFU;
+    }
+
+    inline uint32_t load_crc32c(const uint8_t *bytes) {
+        uint32_t crc = 0;
+        for (int i = 0; i < CRC32C_SIZE; i++)
+            crc = (crc << BIT_TO_BYTE) | bytes[i];
+        return crc;
+    }
+
+    // Number of message bytes which fit into the given number of bits
+    // together with the header (and the trailer) with the given flags.
+    uint64_t header_capacity(uint64_t bits, uint8_t flags);
+
+    // the header of the given size, a message of the given length and
+    // the trailer with the given flags fit into the given number of bits
+    inline bool message_fits(uint64_t bits, size_t header_size, uint64_t length,
+                             uint8_t flags) {
+        uint64_t bytes = bits / BIT_TO_BYTE;
+        size_t around = header_size + trailer_size(flags);
+        return around <= bytes && length <= bytes - around;
+    }
+
+    // Reads the header one byte at a time, so the reading can be
+    // stopped as soon as the header turns out to be invalid.
+    class header_reader {
+    public:
+        enum State {
+            MORE,     // more bytes are needed
+            DONE,     // the header is valid
+            INVALID   // not a header of the expected method
+        };
+
+        explicit header_reader(Method method);
+
+        State push(uint8_t byte);
+
+        const StegHeader &header() const {
+            return result;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+    private:
+        StegHeader result;
+        size_t count;
+        int shift;
+        bool length_done;
+        uint8_t crc;
+    };
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_HEADER_H
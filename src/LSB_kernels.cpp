@@ -0,0 +1,395 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <assert.h>
+#include "LSB_kernels.h"
+#include "CImg.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+using namespace cimg_library;
+
+
+namespace steg {
+
+    // One payload byte spread over 8 samples is a single 64-bit word,
+    // so the scalar path can only be used when the word bytes are
+    // laid out in the same order as the samples.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define STEG_WORD_KERNELS 1
+#endif
+
+    static const uint64_t LSB_CLEAR = 0xFEFEFEFEFEFEFEFEULL;
+    static const uint64_t LSB_ONLY = 0x0101010101010101ULL;
+
+#ifdef STEG_WORD_KERNELS
+
+    // Spreads the bits of a byte into the lowest bit of each byte of
+    // the word, byte 0 receiving the most significant bit.
+    //
+    // Multiplying by 0x8040201008040201 places a copy of the byte at
+    // every 9th bit, so bit (7 - k) of the byte lands on bit 8k + 7
+    // without any of the copies overlapping, which is then shifted
+    // down to bit 8k.
+    static inline uint64_t spread_byte(uint8_t byte) {
+        return ((byte * 0x8040201008040201ULL) >> 7) & LSB_ONLY;
+    }
+
+    // Opposite of spread_byte: the lowest bit of every byte is gathered
+    // into the top byte of the product, bit 8k moving to bit 63 - k.
+    // All the other partial products either fall off the top of the word
+    // or stay below bit 56, and never collide, so there are no carries.
+    static inline uint8_t gather_byte(uint64_t word) {
+        return (uint8_t) (((word & LSB_ONLY) * 0x8040201008040201ULL) >> 56);
+    }
+
+#endif
+
+    static inline void embed_byte(unsigned char *samples, uint8_t byte) {
+#ifdef STEG_WORD_KERNELS
+        uint64_t word;
+        std::memcpy(&word, samples, sizeof(word));
+        word = (word & LSB_CLEAR) | spread_byte(byte);
+        std::memcpy(samples, &word, sizeof(word));
+#else
+        for (int shift_count = 7; shift_count >= 0; shift_count--, samples++) {
+            *samples = (*samples & 0xFEU) | ((byte >> shift_count) & 1U);
+        }
+#endif
+    }
+
+    static inline uint8_t extract_byte(const unsigned char *samples) {
+#ifdef STEG_WORD_KERNELS
+        uint64_t word;
+        std::memcpy(&word, samples, sizeof(word));
+        return gather_byte(word);
+#else
+        uint8_t byte = 0;
+        for (int i = 0; i < 8; i++) {
+            byte = (byte << 1) | (samples[i] & 1U);
+        }
+        return byte;
+#endif
+    }
+
+    void embed_bits(unsigned char *plane, const uint8_t *payload, size_t size) {
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        // 4 payload bytes -> 32 samples: every byte is broadcast over its
+        // 8 samples, each sample then selects its own bit of the byte
+        const __m256i spread = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0,
+                                                1, 1, 1, 1, 1, 1, 1, 1,
+                                                2, 2, 2, 2, 2, 2, 2, 2,
+                                                3, 3, 3, 3, 3, 3, 3, 3);
+        const __m256i select = _mm256_set1_epi64x((long long) 0x0102040810204080ULL);
+        const __m256i keep = _mm256_set1_epi8((char) 0xFE);
+        const __m256i one = _mm256_set1_epi8(1);
+        for (; i + 4 <= size; i += 4) {
+            uint32_t four;
+            std::memcpy(&four, payload + i, sizeof(four));
+            __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32((int) four), spread);
+            __m256i bits = _mm256_and_si256(
+                    _mm256_cmpeq_epi8(_mm256_and_si256(bytes, select), select), one);
+
+            __m256i *dst = reinterpret_cast<__m256i *>(plane + i * 8);
+            __m256i samples = _mm256_loadu_si256(dst);
+            _mm256_storeu_si256(dst, _mm256_or_si256(_mm256_and_si256(samples, keep), bits));
+        }
+#elif defined(__SSE2__)
+        // 2 payload bytes -> 16 samples, same idea as above with the byte
+        // broadcast done by repeated unpacking
+        const __m128i select = _mm_set1_epi64x((long long) 0x0102040810204080ULL);
+        const __m128i keep = _mm_set1_epi8((char) 0xFE);
+        const __m128i one = _mm_set1_epi8(1);
+        for (; i + 2 <= size; i += 2) {
+            __m128i bytes = _mm_cvtsi32_si128(payload[i] | (payload[i + 1] << 8));
+            bytes = _mm_unpacklo_epi8(bytes, bytes);
+            bytes = _mm_unpacklo_epi16(bytes, bytes);
+            bytes = _mm_unpacklo_epi32(bytes, bytes);
+            __m128i bits = _mm_and_si128(
+                    _mm_cmpeq_epi8(_mm_and_si128(bytes, select), select), one);
+
+            __m128i *dst = reinterpret_cast<__m128i *>(plane + i * 8);
+            __m128i samples = _mm_loadu_si128(dst);
+            _mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(samples, keep), bits));
+        }
+#endif
+
+        // remaining bytes (or everything without SIMD support)
+        for (; i < size; i++) {
+            embed_byte(plane + i * 8, payload[i]);
+        }
+    }
+
+    void extract_bits(const unsigned char *plane, uint8_t *payload, size_t size) {
+        size_t i = 0;
+
+#if defined(__AVX2__)
+        // 32 samples -> 4 payload bytes: every group of 8 samples is
+        // reversed so that the first sample ends up in the highest bit,
+        // the LSBs are shifted into the sign bits and collected by movemask
+        const __m256i reverse = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+                                                 15, 14, 13, 12, 11, 10, 9, 8,
+                                                 7, 6, 5, 4, 3, 2, 1, 0,
+                                                 15, 14, 13, 12, 11, 10, 9, 8);
+        for (; i + 4 <= size; i += 4) {
+            __m256i samples = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(plane + i * 8));
+            samples = _mm256_slli_epi16(_mm256_shuffle_epi8(samples, reverse), 7);
+            uint32_t four = (uint32_t) _mm256_movemask_epi8(samples);
+            std::memcpy(payload + i, &four, sizeof(four));
+        }
+#elif defined(__SSE2__)
+        // 16 samples -> 2 payload bytes, the groups of 8 samples are
+        // reversed by swapping the bytes of every word and then the words
+        for (; i + 2 <= size; i += 2) {
+            __m128i samples = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(plane + i * 8));
+            samples = _mm_or_si128(_mm_slli_epi16(samples, 8), _mm_srli_epi16(samples, 8));
+            samples = _mm_shufflelo_epi16(samples, _MM_SHUFFLE(0, 1, 2, 3));
+            samples = _mm_shufflehi_epi16(samples, _MM_SHUFFLE(0, 1, 2, 3));
+            int two = _mm_movemask_epi8(_mm_slli_epi16(samples, 7));
+            payload[i] = (uint8_t) two;
+            payload[i + 1] = (uint8_t) (two >> 8);
+        }
+#endif
+
+        // remaining bytes (or everything without SIMD support)
+        for (; i < size; i++) {
+            payload[i] = extract_byte(plane + i * 8);
+        }
+    }
+
+    static inline bool is_contiguous(const PixelView &image) {
+        return image.pixel_step == 1 && image.stride == image.width;
+    }
+
+    // the rows follow each other without gaps, so the samples of a
+    // channel are all pixel_step apart (e.g. packed interleaved pixels)
+    static inline bool is_flat(const PixelView &image) {
+        return image.height == 1 || image.stride == image.width * image.pixel_step;
+    }
+
+    void embed_bits(const PixelView &image, int channel, uint64_t first,
+                    const uint8_t *payload, size_t size) {
+        if (is_contiguous(image)) {
+            embed_bits(&image(0, 0, channel) + first, payload, size);
+            return;
+        }
+
+        if (is_flat(image)) {
+            unsigned char *samples = &image(0, 0, channel);
+            int64_t offset = first * image.pixel_step;
+            for (size_t i = 0; i < size; i++) {
+                for (int shift_count = BIT_TO_BYTE - 1; shift_count >= 0; shift_count--) {
+                    unsigned char &sample = samples[offset];
+                    sample = (sample & 0xFEU) | ((payload[i] >> shift_count) & 1U);
+                    offset += image.pixel_step;
+                }
+            }
+            return;
+        }
+
+        int w = first % image.width;
+        int h = first / image.width;
+        for (size_t i = 0; i < size; i++) {
+            for (int shift_count = BIT_TO_BYTE - 1; shift_count >= 0; shift_count--) {
+                unsigned char &sample = image(w, h, channel);
+                sample = (sample & 0xFEU) | ((payload[i] >> shift_count) & 1U);
+                if (++w == image.width) {
+                    w = 0;
+                    h++;
+                }
+            }
+        }
+    }
+
+    void extract_bits(const PixelView &image, int channel, uint64_t first,
+                      uint8_t *payload, size_t size) {
+        if (is_contiguous(image)) {
+            extract_bits(&image(0, 0, channel) + first, payload, size);
+            return;
+        }
+
+        if (is_flat(image)) {
+            const unsigned char *samples = &image(0, 0, channel);
+            int64_t offset = first * image.pixel_step;
+            for (size_t i = 0; i < size; i++) {
+                uint8_t to_decode = 0;
+                for (int count = 0; count < BIT_TO_BYTE; count++) {
+                    to_decode = (to_decode << 1) | (samples[offset] & 1U);
+                    offset += image.pixel_step;
+                }
+                payload[i] = to_decode;
+            }
+            return;
+        }
+
+        int w = first % image.width;
+        int h = first / image.width;
+        for (size_t i = 0; i < size; i++) {
+            uint8_t to_decode = 0;
+            for (int count = 0; count < BIT_TO_BYTE; count++) {
+                to_decode = (to_decode << 1) | (image(w, h, channel) & 1U);
+                if (++w == image.width) {
+                    w = 0;
+                    h++;
+                }
+            }
+            payload[i] = to_decode;
+        }
+    }
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    static inline __m128i extreme(__m128i a, __m128i b, bool largest) {
+        return largest ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+    }
+#endif
+
+    size_t extremum_index(const unsigned char *samples, size_t count, bool largest) {
+        // the extreme value is found first and then its first position,
+        // both passes compare a whole vector of samples at a time
+        unsigned char best = samples[0];
+        size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+        if (count >= 16) {
+            __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples));
+            i = 16;
+#if defined(__AVX2__)
+            if (count >= 64) {
+                __m256i wide = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples));
+                for (i = 32; i + 32 <= count; i += 32) {
+                    __m256i more = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+                    wide = largest ? _mm256_max_epu8(wide, more) : _mm256_min_epu8(wide, more);
+                }
+                acc = _mm256_castsi256_si128(wide);
+                __m128i high = _mm256_extracti128_si256(wide, 1);
+                acc = extreme(acc, high, largest);
+            }
+#endif
+            for (; i + 16 <= count; i += 16) {
+                __m128i more = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+                acc = extreme(acc, more, largest);
+            }
+
+            // the 16 bytes are folded in halves down to the lowest one
+            acc = extreme(acc, _mm_srli_si128(acc, 8), largest);
+            acc = extreme(acc, _mm_srli_si128(acc, 4), largest);
+            acc = extreme(acc, _mm_srli_si128(acc, 2), largest);
+            acc = extreme(acc, _mm_srli_si128(acc, 1), largest);
+            best = (unsigned char) _mm_cvtsi128_si32(acc);
+        }
+#endif
+
+        for (; i < count; i++) {
+            if (largest ? samples[i] > best : samples[i] < best)
+                best = samples[i];
+        }
+
+        i = 0;
+#if defined(__AVX2__)
+        const __m256i wanted = _mm256_set1_epi8((char) best);
+        for (; i + 32 <= count; i += 32) {
+            __m256i more = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + i));
+            uint32_t equal = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(more, wanted));
+            if (equal)
+                return i + __builtin_ctz(equal);
+        }
+#elif defined(__SSE2__)
+        const __m128i wanted = _mm_set1_epi8((char) best);
+        for (; i + 16 <= count; i += 16) {
+            __m128i more = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + i));
+            uint32_t equal = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(more, wanted));
+            if (equal)
+                return i + __builtin_ctz(equal);
+        }
+#endif
+        while (samples[i] != best)
+            i++;
+        return i;
+    }
+
+    int row_extremum(const PixelView &image, int channel, int h, bool largest) {
+        if (image.pixel_step == 1)
+            return (int) extremum_index(&image(0, h, channel), image.width, largest);
+
+        int found = 0;
+        unsigned char best = image(0, h, channel);
+        for (int w = 1; w < image.width; w++) {
+            unsigned char sample = image(w, h, channel);
+            if (largest ? sample > best : sample < best) {
+                best = sample;
+                found = w;
+            }
+        }
+        return found;
+    }
+
+    void row_extrema(const PixelView &image, int channel, int h, int count,
+                     bool largest, int *columns) {
+        assert(count >= 1 && count <= image.width);
+        if (count == 1) {
+            columns[0] = row_extremum(image, channel, h, largest);
+            return;
+        }
+
+        // the values of the row are counted, and walking from the extreme
+        // value the value of the count-th pixel (threshold) is found
+        uint32_t histogram[256] = {0};
+        for (int w = 0; w < image.width; w++)
+            histogram[image(w, h, channel)]++;
+
+        int threshold = largest ? 255 : 0;
+        int beyond = 0;
+        while (beyond + (int) histogram[threshold] < count) {
+            beyond += histogram[threshold];
+            threshold += largest ? -1 : 1;
+        }
+
+        // all the pixels beyond the threshold, and the first ones of
+        // the pixels equal to it
+        int equal = count - beyond;
+        for (int w = 0, found = 0; found < count; w++) {
+            int sample = image(w, h, channel);
+            if (largest ? sample > threshold : sample < threshold)
+                columns[found++] = w;
+            else if (sample == threshold && equal > 0) {
+                columns[found++] = w;
+                equal--;
+            }
+        }
+    }
+
+    PixelView image_view(const CImg<unsigned char> &image) {
+        // the view does not own the pixels, decoding never writes through it
+        return PixelView::planar(const_cast<unsigned char *>(image.data()),
+                                 image.width(), image.height(), image.spectrum());
+    }
+
+}
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_KERNELS_H
+#define IMAGE_STEGANOGRPAHY_LSB_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "steganography.h"
+
+namespace steg {
+
+    // Bulk bit-plane kernels shared by the encode/decode methods.
+    //
+    // The kernels work on a contiguous run of samples of a single channel
+    // plane (CImg stores every channel as its own width*height plane), so
+    // the sample of pixel i is simply plane[i].
+
+    // Writes the bits of size payload bytes, most significant bit first,
+    // into the least significant bits of plane[0] .. plane[size * 8 - 1].
+    // Every byte of payload occupies 8 consecutive samples, i.e. exactly the
+    // layout the per-pixel LSB_encode loop produced.
+    void embed_bits(unsigned char *plane, const uint8_t *payload, size_t size);
+
+    // Opposite of embed_bits: collects the least significant bits of
+    // plane[0] .. plane[size * 8 - 1] into size bytes written to payload,
+    // the first sample of every group of 8 becoming the most significant bit.
+    void extract_bits(const unsigned char *plane, uint8_t *payload, size_t size);
+
+    // Same as embed_bits, but for the samples of the given channel of
+    // any image view, starting at the pixel number first (counting the
+    // pixels row by row). Falls back to walking the pixels one by one
+    // when the channel is not stored as a contiguous plane.
+    void embed_bits(const PixelView &image, int channel, uint64_t first,
+                    const uint8_t *payload, size_t size);
+
+    // Same as extract_bits, for the samples of the given channel of any
+    // image view, starting at the pixel number first.
+    void extract_bits(const PixelView &image, int channel, uint64_t first,
+                      uint8_t *payload, size_t size);
+
+    // Index of the first of the count samples with the largest (or, when
+    // largest is false, the smallest) value, count has to be at least 1.
+    size_t extremum_index(const unsigned char *samples, size_t count, bool largest);
+
+    // Column of the first pixel of row h of the image view with the
+    // largest (smallest) value of the channel.
+    int row_extremum(const PixelView &image, int channel, int h, bool largest);
+
+    // Columns of the count pixels of row h with the largest (smallest)
+    // values of the channel, in the order of the columns. Of the pixels
+    // with the same value the ones more to the left are taken, so the
+    // columns depend on the values only. count is 1 to the image width.
+    void row_extrema(const PixelView &image, int channel, int h, int count,
+                     bool largest, int *columns);
+
+    // View of the pixels of CImg image (planar layout), image is not copied
+    PixelView image_view(const cimg_library::CImg<unsigned char> &image);
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_KERNELS_H
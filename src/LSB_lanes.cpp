@@ -0,0 +1,181 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+#include <functional>
+#include "steganography.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_parallel.h"
+#include "CImg.h"
+
+using namespace cimg_library;
+
+
+namespace steg {
+
+
+    static Method lane_method(int lanes, int lane);
+
+    static uint64_t lane_samples(const PixelView &image, int lanes, int lane);
+
+    static void for_lanes(int lanes, uint64_t size, int threads,
+                          const std::function<void(int)> &f);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    bool StegCoding::encode_lanes(const std::string &name,
+                                  const std::vector<std::string> &messages,
+                                  const std::string &stego_image,
+                                  const StegOptions &options) {
+        CImg<unsigned char> src(name.c_str());
+        if (!encode_lanes(image_view(src), messages, options))
+            return false;
+        src.save(stego_image.c_str());
+        return true;
+    }
+
+    bool StegCoding::encode_lanes(const PixelView &image,
+                                  const std::vector<std::string> &messages,
+                                  const StegOptions &options) {
+        // the last lane is the shortest one, nothing is encoded unless
+        // the header fits into every lane
+        int lanes = (int) messages.size();
+        if (lanes == 0 || lane_capacity(image, lanes, lanes - 1, options) == 0)
+            return false;
+
+        uint64_t size = 0;
+        for (const std::string &message : messages)
+            size += message.size();
+
+        for_lanes(lanes, size, options.threads, [&](int lane) {
+            encode_lane(image, messages[lane], lanes, lane, options);
+        });
+        return true;
+    }
+
+    std::vector<std::string> StegCoding::decode_lanes(const std::string &name,
+                                                      int lanes,
+                                                      const StegOptions &options) {
+        CImg<unsigned char> src(name.c_str());
+        return decode_lanes(image_view(src), lanes, options);
+    }
+
+    std::vector<std::string> StegCoding::decode_lanes(const PixelView &image,
+                                                      int lanes,
+                                                      const StegOptions &options) {
+        assert(lanes >= 1);
+
+        // the lengths are not known before the headers are read, so the
+        // lanes are split between threads by how much they can hold
+        uint64_t size = 0;
+        for (int lane = 0; lane < lanes; lane++)
+            size += lane_capacity(image, lanes, lane, options);
+
+        std::vector<std::string> messages(lanes);
+        if (!valid_channels(image, options.channels))
+            return messages;
+        for_lanes(lanes, size, options.threads, [&](int lane) {
+            message_output output(messages[lane]);
+            if (!decode_lane(image, lanes, lane, options, output))
+                messages[lane].clear();
+        });
+        return messages;
+    }
+
+    uint64_t StegCoding::lane_capacity(const PixelView &image,
+                                       int lanes,
+                                       int lane,
+                                       const StegOptions &options) {
+        assert(lanes >= 1 && lane >= 0 && lane < lanes);
+        if (!valid_channels(image, options.channels))
+            return 0;
+        return planes_capacity(lane_samples(image, lanes, lane), options);
+    }
+
+    void encode_lane(const PixelView &image,
+                     const message_bytes &message,
+                     int lanes,
+                     int lane,
+                     const StegOptions &options) {
+        assert(lanes >= 1 && lane >= 0 && lane < lanes);
+        assert(valid_channels(image, options.channels));
+
+        encode_planes(pixel_cursor(image, lane, lanes), lane_samples(image, lanes, lane),
+                      message, lane_method(lanes, lane), options);
+    }
+
+    bool decode_lane(const PixelView &image,
+                     int lanes,
+                     int lane,
+                     const StegOptions &options,
+                     message_output &output) {
+        assert(lanes >= 1 && lane >= 0 && lane < lanes);
+        return decode_planes(pixel_cursor(image, lane, lanes), lane_samples(image, lanes, lane),
+                             lane_method(lanes, lane), options, output);
+    }
+
+    // The method written into the header of the lane: the two lanes
+    // of 2 are the even and odd methods, every other lane holds a plain
+    // LSB stream over its pixels (the single lane of 1 is the LSB method).
+    static Method lane_method(int lanes, int lane) {
+        if (lanes == 2)
+            return lane ? Method::LSB_ODD : Method::LSB_EVEN;
+        return Method::LSB;
+    }
+
+    static uint64_t lane_samples(const PixelView &image, int lanes, int lane) {
+        uint64_t total_pixels = (uint64_t) image.width * image.height;
+        if (total_pixels <= (uint64_t) lane)
+            return 0;
+        return (total_pixels - lane + lanes - 1) / lanes;
+    }
+
+    // Calls f(lane) for every lane, the lanes are split between threads
+    // when the messages (size bytes in all) are large enough. Every lane
+    // has pixels of its own, so the lanes never write the same sample.
+    static void for_lanes(int lanes, uint64_t size, int threads,
+                          const std::function<void(int)> &f) {
+        int parts = std::min(parallel_parts(size, PARALLEL_GRAIN, threads), lanes);
+        if (parts == 1) {
+            for (int lane = 0; lane < lanes; lane++)
+                f(lane);
+            return;
+        }
+
+        parallel_for(parts, lanes, [&](int, uint64_t begin, uint64_t end) {
+            for (uint64_t lane = begin; lane < end; lane++)
+                f((int) lane);
+        });
+    }
+
+}
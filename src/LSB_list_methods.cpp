@@ -25,9 +25,17 @@
 #include <string>
 #include <assert.h>
 #include <iostream>
-#include <functional>
 #include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
 #include "steganography.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_header.h"
+#include "LSB_primes.h"
+#include "LSB_locations.h"
 #include "CImg.h"
 
 using namespace cimg_library;
@@ -36,34 +44,8 @@ using namespace cimg_library;
 namespace steg {
 
 
-    std::vector<int64_t> primes(int64_t limit);
-
-    std::vector<int64_t> compute_spiral_matrix(int64_t size);
-
-    std::vector<int64_t> compute_magic_sq_matrix(int64_t size);
-
-    void encode_length_generic(const uint64_t msg_length,
-                               CImg<unsigned char> &image,
-                               const std::vector<int64_t> &list);
-
-    uint64_t decode_length_generic(CImg<unsigned char> &image,
-                                   const std::vector<int64_t> &list);
-
-    int64_t encode_single_byte_list(uint8_t to_encode,
-                                    CImg<unsigned char> &image,
-                                    int64_t elem,
-                                    const std::vector<int64_t> &list);
-
-    char decode_single_byte(CImg<unsigned char> &image,
-                            int64_t elem, const std::vector<int64_t> &list);
-
-    static void encode_list_generic(const std::string &name,
-                                    const std::string &message,
-                                    const std::string &stego_image,
-                                    const std::function<std::vector<int64_t>(int64_t)> &f);
-
-    static std::string decode_list_generic(std::string name,
-                                           const std::function<std::vector<int64_t>(int64_t)> &f);
+    template<typename Generator>
+    static std::vector<int64_t> locations_generic(int64_t total_pixels, Generator f);
 
 
     //*****************************************************************
@@ -71,232 +53,302 @@ namespace steg {
     //*****************************************************************
 
     void StegCoding::LSB_encode_prime(const std::string &name, const std::string &message) {
-        encode_list_generic(name, message, name, primes);
+        LSB_encode_prime(name, message, name);
     }
 
     void StegCoding::LSB_encode_prime(const std::string &name,
                                       const std::string &message,
                                       const std::string &stego_image) {
-        encode_list_generic(name, message, stego_image, primes);
+        CImg<unsigned char> src(name.c_str());
+        LSB_encode_prime(src, message);
+        src.save(stego_image.c_str());
+    }
+
+    void StegCoding::LSB_encode_prime(CImg<unsigned char> &image,
+                                      const std::string &message) {
+        LSB_encode_prime(image_view(image), message);
+    }
+
+    void StegCoding::LSB_encode_prime(const PixelView &image,
+                                      const std::string &message) {
+        encode(image, message, Method::LSB_PRIME);
     }
 
     std::string StegCoding::LSB_decode_prime(const std::string &name) {
-        return decode_list_generic(name, primes);
+        CImg<unsigned char> src(name.c_str());
+        return LSB_decode_prime(src);
+    }
+
+    std::string StegCoding::LSB_decode_prime(const CImg<unsigned char> &image) {
+        return LSB_decode_prime(image_view(image));
+    }
+
+    std::string StegCoding::LSB_decode_prime(const PixelView &image) {
+        return decode(image, Method::LSB_PRIME);
     }
 
     void StegCoding::LSB_encode_spiral(const std::string &name, const std::string &message) {
-        encode_list_generic(name, message, name, compute_spiral_matrix);
+        LSB_encode_spiral(name, message, name);
     }
 
     void StegCoding::LSB_encode_spiral(const std::string &name,
                                        const std::string &message,
                                        const std::string &stego_image) {
-        encode_list_generic(name, message, stego_image, compute_spiral_matrix);
+        CImg<unsigned char> src(name.c_str());
+        LSB_encode_spiral(src, message);
+        src.save(stego_image.c_str());
+    }
+
+    void StegCoding::LSB_encode_spiral(CImg<unsigned char> &image,
+                                       const std::string &message) {
+        LSB_encode_spiral(image_view(image), message);
+    }
+
+    void StegCoding::LSB_encode_spiral(const PixelView &image,
+                                       const std::string &message) {
+        encode(image, message, Method::LSB_SPIRAL);
     }
 
     std::string StegCoding::LSB_decode_spiral(const std::string &name) {
-        return decode_list_generic(name, compute_spiral_matrix);
+        CImg<unsigned char> src(name.c_str());
+        return LSB_decode_spiral(src);
+    }
+
+    std::string StegCoding::LSB_decode_spiral(const CImg<unsigned char> &image) {
+        return LSB_decode_spiral(image_view(image));
+    }
+
+    std::string StegCoding::LSB_decode_spiral(const PixelView &image) {
+        return decode(image, Method::LSB_SPIRAL);
     }
 
     void StegCoding::LSB_encode_magic_sq(const std::string &name, const std::string &message) {
-        encode_list_generic(name, message, name, compute_magic_sq_matrix);
+        LSB_encode_magic_sq(name, message, name);
     }
 
     void StegCoding::LSB_encode_magic_sq(const std::string &name,
                                          const std::string &message,
                                          const std::string &stego_image) {
-        encode_list_generic(name, message, stego_image, compute_magic_sq_matrix);
+        CImg<unsigned char> src(name.c_str());
+        LSB_encode_magic_sq(src, message);
+        src.save(stego_image.c_str());
     }
 
-    std::string StegCoding::LSB_decode_magic_sq(const std::string &name) {
-        return decode_list_generic(name, compute_magic_sq_matrix);
+    void StegCoding::LSB_encode_magic_sq(CImg<unsigned char> &image,
+                                         const std::string &message) {
+        LSB_encode_magic_sq(image_view(image), message);
     }
 
-    static std::string decode_list_generic(std::string name,
-                                           const std::function<std::vector<int64_t>(int64_t)> &f) {
+    void StegCoding::LSB_encode_magic_sq(const PixelView &image,
+                                         const std::string &message) {
+        encode(image, message, Method::LSB_MAGIC_SQ);
+    }
 
+    std::string StegCoding::LSB_decode_magic_sq(const std::string &name) {
         CImg<unsigned char> src(name.c_str());
-        std::string message = "";
-        uint64_t msg_length;
-
-        auto prime_n = f(src.width() * src.height());
-
-        // decode length and translate it to bits
-        msg_length = decode_length_generic(src, prime_n) * BIT_TO_BYTE + ENCODE_SIZE;
-
-        // decode message
-        int height = src.height();
-        int width = src.width();
-        int total_pixels = width * height;
-
-        for (int nr = ENCODE_SIZE; nr < total_pixels && nr < msg_length; nr += BIT_TO_BYTE) {
-            message += decode_single_byte(src, nr, prime_n);
-        }
-        return message;
+        return LSB_decode_magic_sq(src);
     }
 
+    std::string StegCoding::LSB_decode_magic_sq(const CImg<unsigned char> &image) {
+        return LSB_decode_magic_sq(image_view(image));
+    }
 
-    static void encode_list_generic(const std::string &name,
-                                    const std::string &message,
-                                    const std::string &stego_image,
-                                    const std::function<std::vector<int64_t>(int64_t)> &f) {
+    std::string StegCoding::LSB_decode_magic_sq(const PixelView &image) {
+        return decode(image, Method::LSB_MAGIC_SQ);
+    }
 
-        CImg<unsigned char> src(name.c_str());
-        uint64_t msg_length = message.length();
+    // computes the list of locations for the given image, locations
+    // outside of the image are skipped as they can not be encoded
+    template<typename Generator>
+    static std::vector<int64_t> locations_generic(int64_t total_pixels, Generator f) {
+        auto list = f(total_pixels);
+        list.erase(std::remove_if(list.begin(), list.end(),
+                                  [total_pixels](int64_t pos) { return pos >= total_pixels; }),
+                   list.end());
+        return list;
+    }
 
-        assert(src.width() >= 64 &&
-               src.height() >= 64);
+    std::vector<int64_t> compute_locations(int width, int height, Method method) {
+        assert(method == Method::LSB_PRIME);
+        int64_t total_pixels = (int64_t) width * height;
+        return locations_generic(total_pixels, [](int64_t limit) { return primes(limit); });
+    }
 
-        auto prime_n = f(src.width() * src.height());
+    // Cursor over the pixels of the list, in the order of the list.
+    class list_cursor {
+    public:
+        list_cursor(const PixelView &image, const std::vector<int64_t> &list)
+                : image(image), list(list), samples(image, BLUE), i(0) {}
 
-        // encode length of the text
-        encode_length_generic(msg_length, src, prime_n);
+        void restart(int new_channel) {
+            samples = channel_samples(image, new_channel);
+            i = 0;
+        }
 
-        // encoding the message
-        int64_t elem = ENCODE_SIZE;
-        for (char c : message) {
-            elem = encode_single_byte_list(c, src, elem, prime_n);
+        unsigned char &next() {
+            return samples[list[i++]];
         }
 
-        src.save(stego_image.c_str());
+    private:
+        const PixelView &image;
+        const std::vector<int64_t> &list;
+        channel_samples samples;
+        size_t i;
+    };
+
+    bool decode_list(const PixelView &image,
+                     const std::vector<int64_t> &list,
+                     Method method,
+                     const StegOptions &options,
+                     message_output &output) {
+        return decode_planes(list_cursor(image, list), list.size(), method, options, output);
     }
 
 
-    void encode_length_generic(const uint64_t msg_length,
-                               CImg<unsigned char> &image,
-                               const std::vector<int64_t> &list) {
+    void encode_list(const PixelView &image,
+                     const message_bytes &message,
+                     const std::vector<int64_t> &list,
+                     Method method,
+                     const StegOptions &options) {
 
-        int bit, w, h, elem;
-        int width = image.width();
+        assert(valid_channels(image, options.channels));
 
-        // encoding the size to the picture
-        for (int i = 0, j = ENCODE_SIZE - 1;
-             i < ENCODE_SIZE && j >= 0; i++, j--) {
+        // only as much of the message as there are locations is encoded
+        encode_planes(list_cursor(image, list), list.size(), message, method, options);
+    }
 
-            bit = (msg_length >> j) & 1U; // get the bit at the position
 
-            // changing blue value of the message
-            elem = list[i];
-            w = elem % width; // width
-            h = elem / width; // height
-            image(w, h, BLUE) ^= (-bit ^ image(w, h, BLUE)) & 1U;
+    // Cursor over the locations given one by one by a generator (with
+    // next() returning -1 after the last location), computed only as far
+    // as the cursor gets. Past the last location exhausted is set (and
+    // a dummy sample given).
+    template<typename Generator>
+    class generator_cursor {
+    public:
+        generator_cursor(const PixelView &image, const Generator &first, bool &exhausted)
+                : image(image), first(first), generator(first),
+                  exhausted(exhausted), samples(image, BLUE), dummy(0) {}
+
+        void restart(int new_channel) {
+            samples = channel_samples(image, new_channel);
+            generator = first;
         }
-    }
 
-    int64_t encode_single_byte_list(uint8_t to_encode,
-                                    CImg<unsigned char> &image,
-                                    int64_t elem,
-                                    const std::vector<int64_t> &list) {
+        unsigned char &next() {
+            int64_t pos = generator.next();
+            if (pos < 0) {
+                exhausted = true;
+                return dummy;
+            }
+            return samples[pos];
+        }
 
-        int shift_count = BIT_TO_BYTE - 1;
-        int bit, i, w, h, pos;
-        int width = image.width();
-        // encoding the size to the picture
-        for (i = elem; shift_count >= 0; i++, shift_count--) {
-            bit = (to_encode >> shift_count) & 1U;
+    private:
+        const PixelView &image;
+        Generator first;
+        Generator generator;
+        bool &exhausted;
+        channel_samples samples;
+        unsigned char dummy;
+    };
 
-            pos = list[i];
-            w = pos % width; // width
-            h = pos / width; // height
-            image(w, h, BLUE) ^= (-bit ^ image(w, h, BLUE)) & 1U;
-        }
-        return i;
-    }
-
-    char decode_single_byte(CImg<unsigned char> &image,
-                            int64_t elem, const std::vector<int64_t> &list) {
-        int bit = 0, w, h, pos;
-        int width = image.width();
-        uint8_t to_decode = 0;
-
-        for (int i = elem; i < elem + BIT_TO_BYTE; i++) {
-            pos = list[i];
-            w = pos % width; // width
-            h = pos / width; // height
-            bit = image(w, h, BLUE) & 1U;
-            to_decode <<= 1;
-            to_decode ^= (-bit ^ to_decode) & 1U;
+    void encode_prime(const PixelView &image,
+                      const message_bytes &message,
+                      const StegOptions &options) {
+        assert(valid_channels(image, options.channels));
+
+        // The message is encoded the same way as with the whole list of
+        // primes whenever it certainly fits into the primes of the image,
+        // which the lower bound of their count tells without counting.
+        // Several channels need the exact count, as each of them starts
+        // after all the primes of the previous one.
+        uint8_t flags = header_flags(options);
+        uint64_t length = message.size;
+        uint64_t needed = ((header_size(length) + length + trailer_size(flags)) * BIT_TO_BYTE +
+                           options.bits - 1) / options.bits;
+        uint64_t fewest = prime_count_lower_bound((int64_t) image.width * image.height);
+        if (single_channel(options.channels) < 0 || needed > fewest) {
+            encode_list(image, message, *list_locations(image, Method::LSB_PRIME),
+                        Method::LSB_PRIME, options);
+            return;
         }
 
-        return to_decode;
+        bool exhausted = false;
+        prime_generator primes((int64_t) image.width * image.height);
+        encode_planes(generator_cursor<prime_generator>(image, primes, exhausted),
+                      fewest, message, Method::LSB_PRIME, options);
     }
 
+    bool decode_prime(const PixelView &image,
+                      const StegOptions &options,
+                      message_output &output) {
+        if (single_channel(options.channels) < 0)
+            return decode_list(image, *list_locations(image, Method::LSB_PRIME),
+                               Method::LSB_PRIME, options, output);
+
+        // The number of pixels is more than the number of primes, so a
+        // header is never rejected for its length here, but a message
+        // running past the last prime exhausts the cursor instead, which
+        // is exactly when the whole list would reject it.
+        bool exhausted = false;
+        uint64_t total_pixels = (uint64_t) image.width * image.height;
+        prime_generator primes(total_pixels);
+        bool decoded = decode_planes(
+                generator_cursor<prime_generator>(image, primes, exhausted),
+                total_pixels, Method::LSB_PRIME, options, output);
+        return decoded && !exhausted;
+    }
 
-    uint64_t decode_length_generic(CImg<unsigned char> &image,
-                                   const std::vector<int64_t> &list) {
-
-        uint64_t msg_length = 0;
-        int width = image.width();
-        int total = image.height() * width;
-        int bit, w, h, elem;
-        for (int i = 0; i < ENCODE_SIZE; i++) {
-            msg_length <<= 1;
 
-            elem = list[i];
-            w = elem % width; // width
-            h = elem / width; // height
+    // The spiral and the magic square use every pixel once, so the number
+    // of locations is known without walking them and the locations are
+    // computed only as far as the message goes.
+    template<typename Generator>
+    static void encode_walk(const PixelView &image, const message_bytes &message,
+                            const Generator &walk, Method method,
+                            const StegOptions &options) {
+        assert(valid_channels(image, options.channels));
 
-            bit = image(w, h, BLUE) & 1U;
-            msg_length ^= (-bit ^ msg_length) & 1U;
-        }
-        return msg_length;
+        bool exhausted = false;
+        encode_planes(generator_cursor<Generator>(image, walk, exhausted),
+                      (uint64_t) image.width * image.height, message, method, options);
     }
 
-    /*****************************************************************
-     *
-     *                     PRIME NUMBERS SECTION
-     *
-     *****************************************************************/
+    template<typename Generator>
+    static bool decode_walk(const PixelView &image, const Generator &walk,
+                            Method method, const StegOptions &options,
+                            message_output &output) {
+        bool exhausted = false;
+        return decode_planes(generator_cursor<Generator>(image, walk, exhausted),
+                             (uint64_t) image.width * image.height, method, options, output);
+    }
 
-    // computing primes using the modified implementation of Sieve of Atkin
-    // from http://www.geeksforgeeks.org/sieve-of-atkin/
-    // more about the algorithm can be found in
-    // https://en.wikipedia.org/wiki/Sieve_of_Atkin
-    std::vector<int64_t> primes(int64_t limit) {
-
-        std::vector<int64_t> primes = {2, 3, 5};
-
-        // Initialise the sieve array with false values
-        bool sieve[limit] = {false};
-
-        /* Mark siev[n] is true if one of the following is true:
-         a) n = (4*x*x)+(y*y) has odd number of solutions, i.e., there exist
-            odd number of distinct pairs (x, y) that satisfy the equation and
-            n % 12 = 1 or n % 12 = 5.
-         b) n = (3*x*x)+(y*y) has odd number of solutions and n % 12 = 7
-         c) n = (3*x*x)-(y*y) has odd number of solutions, x > y and n % 12 = 11 */
-        for (int x = 1; x * x < limit; x++) {
-            for (int y = 1; y * y < limit; y++) {
-                // Main part of Sieve of Atkin
-                int n = (4 * x * x) + (y * y);
-                if (n <= limit && (n % 12 == 1 || n % 12 == 5))
-                    sieve[n] ^= true;
-
-                n = (3 * x * x) + (y * y);
-                if (n <= limit && n % 12 == 7)
-                    sieve[n] ^= true;
-
-                n = (3 * x * x) - (y * y);
-                if (x > y && n <= limit && n % 12 == 11)
-                    sieve[n] ^= true;
-            }
-        }
+    void encode_spiral(const PixelView &image,
+                       const message_bytes &message,
+                       const StegOptions &options) {
+        encode_walk(image, message, spiral_walk(image.width, image.height),
+                    Method::LSB_SPIRAL, options);
+    }
 
-        // mark all multiples of squares as non-prime
-        for (int r = 5; r * r < limit; r++) {
-            if (sieve[r]) {
-                for (int i = r * r; i < limit; i += r * r)
-                    sieve[i] = false;
-            }
-        }
+    bool decode_spiral(const PixelView &image,
+                       const StegOptions &options,
+                       message_output &output) {
+        return decode_walk(image, spiral_walk(image.width, image.height),
+                           Method::LSB_SPIRAL, options, output);
+    }
 
-        // add primes to the list
-        for (int i = 5; i < limit; i++) {
-            if (sieve[i])
-                primes.push_back(i);
-        }
+    void encode_magic_square(const PixelView &image,
+                             const message_bytes &message,
+                             const StegOptions &options) {
+        encode_walk(image, message, magic_square_walk((int64_t) image.width * image.height),
+                    Method::LSB_MAGIC_SQ, options);
+    }
 
-        return primes;
+    bool decode_magic_square(const PixelView &image,
+                             const StegOptions &options,
+                             message_output &output) {
+        return decode_walk(image, magic_square_walk((int64_t) image.width * image.height),
+                           Method::LSB_MAGIC_SQ, options, output);
     }
 
 
@@ -306,119 +358,74 @@ namespace steg {
      *
      *****************************************************************/
 
-    enum direction {
-        RIGHT,
-        DOWN,
-        LEFT,
-        UP
-    };
-
-    struct params {
-        direction dir;
-        std::pair<int, int> coord;
-        int steps;
-        int counter;
-    };
-
-    void compute_spiral_line(params &par, int **matrix);
-
-    // computing a sprial matrix, and then collecting the
-    // matrix values into the vector for a further use.
+    // The spiral around the middle pixel (ci, cj) = (height / 2, width / 2)
+    // in offsets a = i - ci, b = j - cj, numbered as if the image was
+    // infinite, goes 1 step down (a + 1), 1 right (b + 1), 2 up, 2 left,
+    // 3 down, 3 right, ... (the steps growing every two turns):
     //
-    // Example:  
+    //          6  5  4 15
+    //          7  0  3 14
+    //          8  1  2 13
+    //          9 10 11 12
     //
-    //         36 17 18 19 20 21
-    //         35 16  5 6   7 22
-    //         34 15  4 1   8 23
-    //         33 14  3 2   9 24
-    //         32 13 12 11 10 25
-    //         31 30 29 28 27 26
-    //
-    // and the list collected will be:
-    // 31 32 30 33 13 29 34 14 12 28 35 15 3 11 27 36 16 4
-    // 2 10 26 17 5 1 9 25 19 7 23 20 22 21 (pattern of collecting 
-    // the elements can be seen from the example)
-    //
-    std::vector<int64_t> compute_spiral_matrix(int64_t size) {
-        const int sz = sqrt(size);
-
-        // alloc
-        int **matrix = new int *[sz];
-        for (int i = 0; i < sz; i++)
-            matrix[i] = new int[sz];
-
-        std::vector<int64_t> list{};
-        int x = sz >> 1, y = sz >> 1;
-
-        int inc = 0;
-        int steps = 1;
-        params par{direction::RIGHT, std::make_pair(x, y), steps, 0};
-
-        while (x >= 0 && y >= 0 && x < sz && y < sz) {
-            compute_spiral_line(par, matrix);
-            if (++inc == 2) {
-                inc = 0;
-                steps++;
+    // After m * m pixels it has filled an m x m square, a in [-t, t] for
+    // m = 2t + 1 and a in [-(t - 1), t] for m = 2t (the same for b), so
+    // the number of a pixel is the size of the smallest square it is not
+    // in plus the pixels of the next shell before it. Clipping these
+    // rectangles to the image counts only the pixels of the image, which
+    // does not change anything for odd sized square images.
+
+    spiral_walk::spiral_walk(int width, int height)
+            : width(width), height(height), diagonal(height - 1), column(0) {}
+
+    int64_t spiral_walk::next() {
+        while (diagonal > -width) {
+            int64_t last = std::min(width - 1, height - 1 - diagonal);
+            if (column <= last) {
+                int64_t pos = rank(diagonal + column, column);
+                column++;
+                return pos;
             }
-            par.steps = steps;
-            x = par.coord.first;
-            y = par.coord.second;
+            diagonal--;
+            column = std::max<int64_t>(0, -diagonal);
         }
-
-        int row, temp;
-        for (int r = sz - 1; r > -sz; --r) {
-            temp = abs(r);
-            row = (temp != r) ? 0 : r; //abs(r); // should be 0
-
-            for (int c = temp - row; c < sz - row; ++c) {
-                list.push_back(matrix[r + c][c]);
-            }
-        }
-
-        // dealloc
-        for (int i = 0; i < sz; i++) {
-            delete[] matrix[i];
-        }
-        delete[] matrix;
-
-        return list;
+        return -1;
     }
 
-
-    void compute_spiral_line(params &par, int **matrix) {
-        int steps = par.steps;
-        int counter = par.counter;
-        int x = par.coord.first, y = par.coord.second;
-        int x_inc = 0, y_inc = 0;
-
-        switch (par.dir) {
-            case RIGHT:
-                x_inc = 1;
-                par.dir = direction::DOWN;
-                break;
-            case DOWN:
-                y_inc = 1;
-                par.dir = direction::LEFT;
-                break;
-            case LEFT:
-                x_inc = -1;
-                par.dir = direction::UP;
-                break;
-            case UP:
-                y_inc = -1;
-                par.dir = direction::RIGHT;
-                break;
+    int64_t spiral_walk::rank(int64_t i, int64_t j) const {
+        int64_t a = i - height / 2;
+        int64_t b = j - width / 2;
+
+        // the shell of the pixel, the smaller of the two candidates
+        int64_t odd_t = std::max(std::abs(a), std::abs(b));
+        int64_t even_t = std::max(std::max(a, b), 1 - std::min(a, b));
+
+        if (2 * even_t < 2 * odd_t + 1) {
+            // 2t x 2t shell: down the column a = t, then left along b = t
+            int64_t t = even_t;
+            int64_t before = cells(-(t - 1), t - 1, -(t - 1), t - 1);
+            if (a == t && b < t)
+                return before + cells(t, t, -(t - 1), b - 1);
+            return before + cells(t, t, -(t - 1), t - 1) + cells(a + 1, t, t, t);
         }
 
-        while (steps--) {
-            matrix[x][y] = counter++;
-            x += x_inc;
-            y += y_inc;
-        }
+        // (2t + 1) x (2t + 1) shell: up the column a = -t, then right
+        // along b = -t
+        int64_t t = odd_t;
+        int64_t before = cells(-(t - 1), t, -(t - 1), t);
+        if (a == -t && b > -t)
+            return before + cells(-t, -t, b + 1, t);
+        return before + cells(-t, -t, -t + 1, t) + cells(-t, a - 1, -t, -t);
+    }
 
-        par.counter = counter;
-        par.coord.first = x;
-        par.coord.second = y;
+    // number of the pixels of the image with the offsets a in [a_lo, a_hi]
+    // and b in [b_lo, b_hi]
+    int64_t spiral_walk::cells(int64_t a_lo, int64_t a_hi, int64_t b_lo, int64_t b_hi) const {
+        int64_t rows = std::min(a_hi, height - 1 - height / 2) - std::max(a_lo, -(height / 2)) + 1;
+        int64_t columns = std::min(b_hi, width - 1 - width / 2) - std::max(b_lo, -(width / 2)) + 1;
+        if (rows <= 0 || columns <= 0)
+            return 0;
+        return rows * columns;
     }
 
 
@@ -428,44 +435,57 @@ namespace steg {
     *
     *****************************************************************/
 
-
-
-    // computing the magic square matrix by using the algorithm
-    // from https://introcs.cs.princeton.edu/java/14array/MagicSquare.java.html
+    // The odd sized magic square of the Siamese method: 0 is put into the
+    // middle of the bottom row, every next number one cell down and right
+    // (wrapping around the edges), and when that cell is taken (after
+    // every n numbers) one cell up instead. Number k * n + s is therefore
+    // s steps down and right from the start of the k-th run, which is
+    // (n - 1 - 2k, n / 2 - k), and the other way round the cell (r, c)
+    // belongs to the run k = n - 1 - n / 2 - (r - c) (mod n) and holds
+    // s = c - n / 2 + k (mod n).
+    //
+    // Read row by row, k grows by 1 and s by 2 (mod n) from one column
+    // to the next, and both drop by 1 from one row to the next, so the
+    // cells are walked with additions only. Row 0 starts at k = n / 2
+    // and s = 0.
+    //
     // more about the algorithm can be found in
-    // https://en.wikipedia.org/wiki/Magic_square
-    std::vector<int64_t> compute_magic_sq_matrix(int64_t size) {
-
-        int n = sqrt(size) + 1;
-        n = (n % 2 == 0) ? n + 1 : n;
-        std::vector<int64_t> list{};
-
-        // A function to generate odd sized magic squares
-        int magic[n][n];
-        for (int i = 0; i < n; i++)
-            for (int j = 0; j < n; j++)
-                magic[i][j] = 0;
-
-        int row = n - 1;
-        int col = n / 2;
-        magic[row][col] = 0;
-
-        for (int i = 2; i <= n * n; i++) {
-            if (magic[(row + 1) % n][(col + 1) % n] == 0) {
-                row = (row + 1) % n;
-                col = (col + 1) % n;
-            } else {
-                row = (row - 1 + n) % n;
-            }
-            magic[row][col] = i;
-        }
+    // https://en.wikipedia.org/wiki/Siamese_method
+
+    magic_square_walk::magic_square_walk(int64_t total_pixels)
+            : total_pixels(total_pixels), n(0), row(0), column(0),
+              k(0), s(0), row_k(0), row_s(0) {
+        // the smallest odd n with n * n > total_pixels
+        n = (int64_t) std::sqrt((double) total_pixels);
+        while (n * n > total_pixels)
+            n--;
+        while ((n + 1) * (n + 1) <= total_pixels)
+            n++;
+        n++;
+        if (n % 2 == 0)
+            n++;
+
+        k = row_k = n / 2;
+    }
 
-        for (int i = 0; i < n; i++) {
-            for (int j = 0; j < n; j++) {
-                list.push_back(magic[i][j]);
+    int64_t magic_square_walk::next() {
+        // the numbers past the last pixel are skipped, n is at most
+        // sqrt(total_pixels) + 2, so there are at most 4(n - 1) of them
+        while (row < n) {
+            int64_t pos = k * n + s;
+            if (++column < n) {
+                k = k + 1 == n ? 0 : k + 1;
+                s = s + 2 >= n ? s + 2 - n : s + 2;
+            } else {
+                row++;
+                column = 0;
+                k = row_k = row_k == 0 ? n - 1 : row_k - 1;
+                s = row_s = row_s == 0 ? n - 1 : row_s - 1;
             }
+            if (pos < total_pixels)
+                return pos;
         }
-
-        return list;
+        return -1;
     }
+
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_LOCATIONS_H
+#define IMAGE_STEGANOGRPAHY_LSB_LOCATIONS_H
+
+#include <cstdint>
+
+namespace steg {
+
+    // Generators of the locations of the list methods, giving the
+    // locations one by one (next() returns -1 after the last one), so
+    // no list of all of them has to be built.
+
+    // The spiral method. The pixels of the image, taken as a matrix with
+    // height rows i and width columns j, are visited diagonal by diagonal
+    // (from the bottom left corner to the top right one), and every pixel
+    // gives its number on the spiral which starts in the middle of the
+    // image and winds around it. Only the pixels of the image are counted,
+    // so the numbers of all the pixels are used exactly once.
+    //
+    // Example (3x3):
+    //
+    //          6 5 4                the spiral goes down from the middle,
+    //          7 0 3                then right, up and left (counter
+    //          8 1 2                clockwise), the locations are
+    //                               8 7 1 6 0 2 5 3 4
+    //
+    class spiral_walk {
+    public:
+        spiral_walk(int width, int height);
+
+        int64_t next();
+
+        // number of the pixel in row i and column j on the spiral
+        int64_t rank(int64_t i, int64_t j) const;
+
+    private:
+        int64_t width;
+        int64_t height;
+        int64_t diagonal;   // i - j of the current diagonal
+        int64_t column;     // next j on the diagonal
+
+        int64_t cells(int64_t a_lo, int64_t a_hi, int64_t b_lo, int64_t b_hi) const;
+    };
+
+    // The magic square method. The numbers of the n x n Siamese magic
+    // square (n the smallest odd number with n * n larger than the number
+    // of pixels, numbers from 0) read row by row are the locations, the
+    // numbers past the last pixel are skipped, so every pixel is used
+    // exactly once. The number of every cell follows from the one before
+    // it, the square is never built.
+    //
+    // Example (5x5, the locations of a 3x3 image are 1 8 2 3 5 4 6 0 7):
+    //
+    //          10 17 24  1  8
+    //           9 11 18 20  2
+    //           3  5 12 19 21
+    //          22  4  6 13 15
+    //          16 23  0  7 14
+    //
+    class magic_square_walk {
+    public:
+        explicit magic_square_walk(int64_t total_pixels);
+
+        int64_t next();
+
+    private:
+        int64_t total_pixels;
+        int64_t n;
+        int64_t row;        // next cell
+        int64_t column;
+        int64_t k;          // run and step in the run of the next cell
+        int64_t s;
+        int64_t row_k;      // run and step of the first cell of the row
+        int64_t row_s;
+    };
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_LOCATIONS_H
@@ -26,7 +26,12 @@
 #include <assert.h>
 #include <iostream>
 #include <functional>
+#include <vector>
 #include "steganography.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_parallel.h"
 #include "CImg.h"
 
 using namespace cimg_library;
@@ -35,17 +40,18 @@ using namespace cimg_library;
 namespace steg {
 
 
-    static char LSB_decode_single_byte(CImg<unsigned char> &image,
-                                       std::pair<int, int> &coord);
+    static bool LSB_decode_header(const PixelView &image, int channel,
+                                  uint64_t total_pixels, header_reader &reader);
 
-    static uint64_t LSB_decode_length(CImg<unsigned char> &image);
+    static size_t LSB_enocde_header(const uint64_t msg_length,
+                                    uint8_t flags,
+                                    const PixelView &image,
+                                    int channel);
 
-    static void LSB_enocde_length(const uint64_t msg_length,
-                                  CImg<unsigned char> &image);
-
-    static std::pair<int, int> LSB_encode_single_byte(uint8_t to_encode,
-                                                      CImg<unsigned char> &image,
-                                                      std::pair<int, int> &coord);
+    static uint32_t LSB_process_message(uint64_t msg_length,
+                                        const StegOptions &options,
+                                        bool checksum,
+                                        const std::function<uint32_t(uint64_t, uint64_t)> &range);
 
 
     //*****************************************************************
@@ -62,125 +68,196 @@ namespace steg {
                                 const std::string &message,
                                 const std::string &stego_image) {
         CImg<unsigned char> src(name.c_str());
-        uint64_t msg_length = message.length();
-
-        assert(src.width() >= 64 &&  // width and height of correct size
-               src.height() >= 64);
-
-        // encode length of the text
-        LSB_enocde_length(msg_length, src);
-
-        // encoding the actual message
-        auto coord = std::make_pair(ENCODE_SIZE, 0);
-        for (char c : message) {
-            coord = LSB_encode_single_byte(c, src, coord);
-        }
+        LSB_encode(src, message);
 
         // save the encoded image
         src.save(stego_image.c_str());
     }
 
+    void StegCoding::LSB_encode(CImg<unsigned char> &image,
+                                const std::string &message) {
+        LSB_encode(image_view(image), message);
+    }
+
+    void StegCoding::LSB_encode(const PixelView &image,
+                                const std::string &message) {
+        encode_message(image, message, Method::LSB, StegOptions());
+    }
+
     std::string StegCoding::LSB_decode(const std::string &name) {
+        // PNG files are decompressed only up to the end of the message
+        std::string message;
+        if (decode_png_rows(name, Method::LSB, StegOptions(), message))
+            return message;
+
         CImg<unsigned char> src(name.c_str());
-        std::string message = "";
-        uint64_t msg_length = 0;
-
-        // decode length and translate it to bits
-        msg_length = LSB_decode_length(src) * BIT_TO_BYTE
-                     + ENCODE_SIZE;
-
-        // decode message
-        int width = src.width();
-        int total_pixels = width * src.height();
-        // coordinates to pass into the decode single byte
-        auto coord = std::make_pair(ENCODE_SIZE, 0);
-        for (int nr = ENCODE_SIZE; nr < total_pixels && nr < msg_length;
-             nr += BIT_TO_BYTE) {
-            // determine the the pixel coordinates
-            coord.first = nr % width; // width
-            coord.second = nr / width; //height
-            message += LSB_decode_single_byte(src, coord);
+        return LSB_decode(src);
+    }
 
-        }
-        return message;
+    std::string StegCoding::LSB_decode(const CImg<unsigned char> &image) {
+        return LSB_decode(image_view(image));
     }
 
-    static char LSB_decode_single_byte(CImg<unsigned char> &image,
-                                       std::pair<int, int> &coord) {
-        // bit to be retrieved from a single pixel
-        int bit = 0;
-        // single byte to decode
-        uint8_t to_decode = 0;
-        // width pixel
-        int w = coord.first;
-        int count = 0;
-        for (int h = coord.second; h < image.height(); h++) {
-            for (; w < image.width() && count < BIT_TO_BYTE; w++, count++) {
-                // retrieve a single bit
-                bit = image(w, h, BLUE) & 1U;
-                // update the byte
-                to_decode <<= 1;
-                to_decode ^= (-bit ^ to_decode) & 1U;
-            }
-            w = 0;
-        }
-        return to_decode;
+    std::string StegCoding::LSB_decode(const PixelView &image) {
+        return decode(image, Method::LSB);
     }
 
-    static uint64_t LSB_decode_length(CImg<unsigned char> &image) {
-        uint64_t msg_length = 0;
-        int bit;
-        for (int i = 0; i < ENCODE_SIZE; i++) {
-            msg_length <<= 1;
-            // get the bit at the specific pixel
-            bit = image(i, 0, BLUE) & 1U;
+    void encode_sequential(const PixelView &image,
+                           const message_bytes &message,
+                           const StegOptions &options) {
+        uint64_t msg_length = message.size;
 
-            // update the length
-            msg_length ^= (-bit ^ msg_length) & 1U;
+        assert(valid_channels(image, options.channels));
+
+        uint64_t total_pixels = (uint64_t) image.width * image.height;
+        int channel = single_channel(options.channels);
+        if (options.bits != 1 || channel < 0) {
+            encode_planes(pixel_cursor(image, 0, 1), total_pixels, message,
+                          Method::LSB, options);
+            return;
         }
-        return msg_length;
 
+        // an image too small for the header is left untouched
+        uint8_t flags = header_flags(options);
+        if (!header_fits(total_pixels, 1, flags))
+            return;
+
+        // only as much of the message as fits into the image is encoded
+        uint64_t capacity = header_capacity(total_pixels, flags);
+        if (msg_length > capacity)
+            msg_length = capacity;
+
+        // encode the header with the length of the text
+        size_t size = LSB_enocde_header(msg_length, flags, image, channel);
+
+        // encoding the actual message, the checksum is computed over
+        // the same piece of the message right after it is encoded
+        const uint8_t *payload = message.data;
+        uint64_t first = size * BIT_TO_BYTE;
+        bool checksum = flags & HEADER_FLAG_CRC32C;
+        uint32_t crc = LSB_process_message(
+                msg_length, options, checksum,
+                [&](uint64_t begin, uint64_t end) {
+                    uint32_t range_crc = 0;
+                    for (uint64_t done = begin; done < end; done += STREAM_CHUNK) {
+                        size_t chunk = end - done < STREAM_CHUNK ? end - done : STREAM_CHUNK;
+                        embed_bits(image, channel, first + done * BIT_TO_BYTE, payload + done, chunk);
+                        if (checksum)
+                            range_crc = crc32c(range_crc, payload + done, chunk);
+                    }
+                    return range_crc;
+                });
+
+        if (flags & HEADER_FLAG_CRC32C) {
+            uint8_t trailer[CRC32C_SIZE];
+            store_crc32c(crc, trailer);
+            embed_bits(image, channel, first + msg_length * BIT_TO_BYTE,
+                       trailer, sizeof(trailer));
+        }
     }
 
+    bool decode_sequential(const PixelView &image,
+                           const StegOptions &options,
+                           message_output &output) {
+        uint64_t total_pixels = (uint64_t) image.width * image.height;
+        int channel = single_channel(options.channels);
+        if (options.bits != 1 || channel < 0)
+            return decode_planes(pixel_cursor(image, 0, 1), total_pixels,
+                                 Method::LSB, options, output);
+
+        // decode header, images without a valid one have no message
+        header_reader reader(Method::LSB);
+        if (!LSB_decode_header(image, channel, total_pixels, reader))
+            return false;
+
+        uint8_t flags = reader.header().flags;
+        uint64_t msg_length = reader.header().length;
+        if (!message_fits(total_pixels, reader.size(), msg_length, flags))
+            return false;
+
+        // decode message straight into the output sized by the header,
+        // checking each piece of it while it is still in the cache
+        uint8_t *payload = output.reserve(msg_length);
+        if (!payload)
+            return false;
+        uint64_t first = reader.size() * BIT_TO_BYTE;
+        bool checksum = flags & HEADER_FLAG_CRC32C;
+        uint32_t crc = LSB_process_message(
+                msg_length, options, checksum,
+                [&](uint64_t begin, uint64_t end) {
+                    uint32_t range_crc = 0;
+                    for (uint64_t done = begin; done < end; done += STREAM_CHUNK) {
+                        size_t chunk = end - done < STREAM_CHUNK ? end - done : STREAM_CHUNK;
+                        extract_bits(image, channel, first + done * BIT_TO_BYTE, payload + done, chunk);
+                        if (checksum)
+                            range_crc = crc32c(range_crc, payload + done, chunk);
+                    }
+                    return range_crc;
+                });
+
+        if (flags & HEADER_FLAG_CRC32C) {
+            uint8_t trailer[CRC32C_SIZE];
+            extract_bits(image, channel, first + msg_length * BIT_TO_BYTE,
+                         trailer, sizeof(trailer));
+            if (load_crc32c(trailer) != crc)
+                return false;
+        }
+        return true;
+    }
 
-    static void LSB_enocde_length(const uint64_t msg_length,
-                                  CImg<unsigned char> &image) {
+    static bool LSB_decode_header(const PixelView &image, int channel,
+                                  uint64_t total_pixels, header_reader &reader) {
+        // a byte at a time, so that a missing header is noticed early
+        uint8_t byte;
+        header_reader::State state = header_reader::MORE;
+        for (uint64_t first = 0; state == header_reader::MORE; first += BIT_TO_BYTE) {
+            if (first + BIT_TO_BYTE > total_pixels)
+                return false;
+            extract_bits(image, channel, first, &byte, 1);
+            state = reader.push(byte);
+        }
+        return state == header_reader::DONE;
+    }
 
-        int bit;
-        // encoding the size to the picture
-        for (int i = ENCODE_SIZE - 1, j = 0; i >= 0; i--, j++) {
-            // get the bit at the position
-            bit = (msg_length >> j) & 1U;
 
-            // changing blue value of the message
-            image(i, 0, BLUE) ^= (-bit ^ image(i, 0, BLUE)) & 1U;
-        }
+    static size_t LSB_enocde_header(const uint64_t msg_length,
+                                    uint8_t flags,
+                                    const PixelView &image,
+                                    int channel) {
+        // encoding the header to the first pixels of the picture, the
+        // bytes of the header are in the same order as the message bits
+        uint8_t header[HEADER_MAX_SIZE];
+        size_t size = write_header(StegHeader{Method::LSB, flags, msg_length}, header);
+        embed_bits(image, channel, 0, header, size);
+        return size;
     }
 
-    static std::pair<int, int> LSB_encode_single_byte(uint8_t to_encode,
-                                                      CImg<unsigned char> &image,
-                                                      std::pair<int, int> &coord) {
-        int shift_count = BIT_TO_BYTE - 1;
-        int bit;
-        int w = coord.first;
-        for (int h = coord.second; h < image.height(); h++) {
-            for (; w < image.width(); w++) {
-                bit = (to_encode >> shift_count) & 1U;
-                shift_count--;
-                image(w, h, BLUE) ^= (-bit ^ image(w, h, BLUE)) & 1U;
-
-                if (shift_count < 0) {
-                    coord.first = w + 1;
-                    coord.second = h;
-                    goto end;
-                }
-            }
-            w = 0;
-        }
-        end:
-        return coord;
 
+    // The bits of every message byte are at a fixed position, so the
+    // message is split into ranges of bytes processed by range(begin, end)
+    // on separate threads, which return the checksum of their range.
+    static uint32_t LSB_process_message(uint64_t msg_length,
+                                        const StegOptions &options,
+                                        bool checksum,
+                                        const std::function<uint32_t(uint64_t, uint64_t)> &range) {
+        int parts = parallel_parts(msg_length, PARALLEL_GRAIN, options.threads);
+        if (parts == 1)
+            return range(0, msg_length);
+
+        std::vector<uint32_t> crcs(parts);
+        std::vector<uint64_t> sizes(parts);
+        parallel_for(parts, msg_length, [&](int part, uint64_t begin, uint64_t end) {
+            crcs[part] = range(begin, end);
+            sizes[part] = end - begin;
+        });
+
+        uint32_t crc = crcs[0];
+        if (checksum) {
+            for (int part = 1; part < parts; part++)
+                crc = crc32c_combine(crc, crcs[part], sizes[part]);
+        }
+        return crc;
     }
 
 
-}
\ No newline at end of file
+}
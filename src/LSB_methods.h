@@ -0,0 +1,182 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_METHODS_H
+#define IMAGE_STEGANOGRPAHY_LSB_METHODS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "steganography.h"
+
+namespace steg {
+
+    // Internals of the methods taking the encoding options, the
+    // LSB_encode_xxx/LSB_decode_xxx functions use the default options.
+    // The messages are given as message_bytes and decoded into a
+    // message_output (see LSB_engine.h), the decode functions return
+    // false if there is no (valid) message.
+
+    struct message_bytes;
+
+    class message_output;
+
+    // StegCoding::encode/decode with the message in any memory
+    void encode_message(const PixelView &image,
+                        const message_bytes &message,
+                        Method method,
+                        const StegOptions &options);
+
+    bool decode_message(const PixelView &image,
+                        Method method,
+                        const StegOptions &options,
+                        message_output &output);
+
+    void encode_sequential(const PixelView &image,
+                           const message_bytes &message,
+                           const StegOptions &options);
+
+    bool decode_sequential(const PixelView &image,
+                           const StegOptions &options,
+                           message_output &output);
+
+    // Lane lane of lanes: the pixels lane, lane + lanes, lane + 2 * lanes,
+    // ... (counting the pixels row by row), each lane holding a message
+    // of its own. The odd and even methods are the lanes 1 and 0 of 2.
+    void encode_lane(const PixelView &image,
+                     const message_bytes &message,
+                     int lanes,
+                     int lane,
+                     const StegOptions &options);
+
+    bool decode_lane(const PixelView &image,
+                     int lanes,
+                     int lane,
+                     const StegOptions &options,
+                     message_output &output);
+
+    // Decodes the message of the PNG file name with the LSB, LSB_ODD or
+    // LSB_EVEN method, decompressing the rows only up to the last one
+    // holding the message. Returns false if the file can not be read
+    // row by row (not a non-interlaced PNG), otherwise the message (empty
+    // if there is none or the file is damaged) is set.
+    bool decode_png_rows(const std::string &name, Method method,
+                         const StegOptions &options, std::string &message);
+
+    // The prime method is split into computing the locations and using
+    // them, so that the locations can be computed once and reused for the
+    // same image. The spiral and the magic square compute their locations
+    // as they are used (see LSB_locations.h).
+
+    // Locations (pixel numbers counting row by row) used by the prime
+    // method for an image of the given size, in the order the bits are
+    // encoded, computed from scratch.
+    std::vector<int64_t> compute_locations(int width, int height, Method method);
+
+    // the list of locations shared by all the threads, never changed
+    typedef std::shared_ptr<const std::vector<int64_t>> location_list;
+
+    // Default limit of the memory taken by the process-wide cache of the
+    // locations (StegCoding::set_location_cache_limit changes it).
+#define LOCATION_CACHE_LIMIT (64 * 1024 * 1024)
+
+    // Same as compute_locations, but the locations depend only on the
+    // size of the image, so they are kept in a process-wide cache and
+    // the images of the same size share them.
+    location_list list_locations(int width, int height, Method method);
+
+    location_list list_locations(const PixelView &image, Method method);
+
+    // the list of list_locations if it is in the cache already, otherwise
+    // an empty pointer, nothing is computed
+    location_list cached_locations(int width, int height, Method method);
+
+    void encode_list(const PixelView &image,
+                     const message_bytes &message,
+                     const std::vector<int64_t> &list,
+                     Method method,
+                     const StegOptions &options);
+
+    bool decode_list(const PixelView &image,
+                     const std::vector<int64_t> &list,
+                     Method method,
+                     const StegOptions &options,
+                     message_output &output);
+
+    // The prime method, computing only as many primes as the message
+    // needs when possible, instead of the whole list of locations.
+    void encode_prime(const PixelView &image,
+                      const message_bytes &message,
+                      const StegOptions &options);
+
+    bool decode_prime(const PixelView &image,
+                      const StegOptions &options,
+                      message_output &output);
+
+    // the spiral and magic square methods, computing the locations as
+    // they are used
+    void encode_spiral(const PixelView &image,
+                       const message_bytes &message,
+                       const StegOptions &options);
+
+    bool decode_spiral(const PixelView &image,
+                       const StegOptions &options,
+                       message_output &output);
+
+    void encode_magic_square(const PixelView &image,
+                             const message_bytes &message,
+                             const StegOptions &options);
+
+    bool decode_magic_square(const PixelView &image,
+                             const StegOptions &options,
+                             message_output &output);
+
+    // Number of message bytes the method can encode into an image of the
+    // given size, 0 if the channels of the options are not in the image.
+    uint64_t image_capacity(int width, int height, int channels,
+                            Method method, const StegOptions &options);
+
+    // the options the min/max methods use, without the RED channel
+    StegOptions min_max_options(const StegOptions &options);
+
+    // number of pixels the min/max methods use, row_pixels of the
+    // options (at most the width) in every row
+    uint64_t min_max_samples(int width, int height, const StegOptions &options);
+
+    // method is either LSB_MAX or LSB_MIN
+    void encode_min_max(const PixelView &image,
+                        const message_bytes &message,
+                        Method method,
+                        const StegOptions &options);
+
+    bool decode_min_max(const PixelView &image,
+                        Method method,
+                        const StegOptions &options,
+                        message_output &output);
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_METHODS_H
@@ -25,45 +25,34 @@
 #include <string>
 #include <assert.h>
 #include <iostream>
-#include <functional>
 #include <vector>
+#include <algorithm>
 #include "steganography.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_parallel.h"
 #include "CImg.h"
-#include <climits>
 
 using namespace cimg_library;
 
 
 namespace steg {
 
-    static int find_max_location(const CImg<unsigned char> &image, int height);
+    // Rows of the first block scanned for the column of the pixel used,
+    // enough for the header of a short message.
+#define MIN_MAX_BLOCK 64
 
-    static int find_min_location(const CImg<unsigned char> &image, int height);
+    // Smallest number of pixels in the rows scanned by a thread.
+#define MIN_MAX_GRAIN (1024 * 1024)
 
-    static std::string generic_min_max_decode(std::string name,
-                                              const std::function<int(const CImg<unsigned char> &, int)> &f);
-
-    static void generic_min_max_encode(std::string name,
-                                       std::string message,
-                                       std::string steg_image,
-                                       const std::function<int(const CImg<unsigned char> &, int)> &f);
-
-    void encode_length(uint64_t msg_length,
-                       CImg<unsigned char> &image,
-                       const std::function<int(const CImg<unsigned char> &, int)> &f);
-
-    uint64_t decode_length(const CImg<unsigned char> &image,
-                           const std::function<int(const CImg<unsigned char> &, int)> &f);
-
-    void encode_single_byte(uint8_t to_encode,
-                            CImg<unsigned char> &image,
-                            const std::function<int(const CImg<unsigned char> &, int)> &f,
-                            int64_t height);
-
-    char decode_single_byte(const CImg<unsigned char> &image,
-                            const std::function<int(const CImg<unsigned char> &, int)> &f,
-                            int64_t height);
+    template<typename Location>
+    static void encode_rows(const PixelView &image, const message_bytes &message,
+                            Method method, const StegOptions &options);
 
+    template<typename Location>
+    static bool decode_rows(const PixelView &image, Method method,
+                            const StegOptions &options, message_output &output);
 
     //*****************************************************************
     //*****************************************************************
@@ -72,158 +61,226 @@ namespace steg {
 
     void StegCoding::LSB_encode_max(const std::string &name,
                                     const std::string &message) {
-        generic_min_max_encode(name, message, name, find_max_location);
+        LSB_encode_max(name, message, name);
     }
 
     void StegCoding::LSB_encode_max(const std::string &name,
                                     const std::string &message,
                                     const std::string &stego_image) {
-        generic_min_max_encode(name, message, stego_image, find_max_location);
+        CImg<unsigned char> src(name.c_str());
+        LSB_encode_max(src, message);
+        src.save(stego_image.c_str());
+    }
+
+    void StegCoding::LSB_encode_max(CImg<unsigned char> &image,
+                                    const std::string &message) {
+        LSB_encode_max(image_view(image), message);
+    }
+
+    void StegCoding::LSB_encode_max(const PixelView &image,
+                                    const std::string &message) {
+        encode(image, message, Method::LSB_MAX);
     }
 
 
     std::string StegCoding::LSB_decode_max(const std::string &name) {
-        return generic_min_max_decode(name, find_max_location);
+        CImg<unsigned char> src(name.c_str());
+        return LSB_decode_max(src);
+    }
+
+    std::string StegCoding::LSB_decode_max(const CImg<unsigned char> &image) {
+        return LSB_decode_max(image_view(image));
+    }
+
+    std::string StegCoding::LSB_decode_max(const PixelView &image) {
+        return decode(image, Method::LSB_MAX);
     }
 
 
     void StegCoding::LSB_encode_min(const std::string &name,
                                     const std::string &message) {
-        generic_min_max_encode(name, message, name, find_min_location);
+        LSB_encode_min(name, message, name);
     }
 
     void StegCoding::LSB_encode_min(const std::string &name,
                                     const std::string &message,
                                     const std::string &stego_image) {
-        generic_min_max_encode(name, message, stego_image, find_min_location);
+        CImg<unsigned char> src(name.c_str());
+        LSB_encode_min(src, message);
+        src.save(stego_image.c_str());
     }
 
-    std::string StegCoding::LSB_decode_min(const std::string &name) {
-        return generic_min_max_decode(name, find_min_location);
+    void StegCoding::LSB_encode_min(CImg<unsigned char> &image,
+                                    const std::string &message) {
+        LSB_encode_min(image_view(image), message);
     }
 
-    void encode_single_byte(uint8_t to_encode,
-                            CImg<unsigned char> &image,
-                            const std::function<int(const CImg<unsigned char> &, int)> &f,
-                            int64_t height) {
-
-        int bit, w;
-        int h2 = image.height();
-
-        // encoding the size to the picture
-        for (int h = height, shift_count = BIT_TO_BYTE - 1;
-             shift_count >= 0 && h < h2; h++, shift_count--) {
-
-            bit = (to_encode >> shift_count) & 1U;
-            w = f(image, h);
-            image(w, h, BLUE) ^= (-bit ^ image(w, h, BLUE)) & 1U;
-        }
+    void StegCoding::LSB_encode_min(const PixelView &image,
+                                    const std::string &message) {
+        encode(image, message, Method::LSB_MIN);
     }
 
-    char decode_single_byte(const CImg<unsigned char> &image,
-                            const std::function<int(const CImg<unsigned char> &, int)> &f,
-                            int64_t height) {
-        int bit = 0, w;
-        uint8_t to_decode = 0;
-
-        for (int h = height; h < height + BIT_TO_BYTE; h++) {
-            w = f(image, h);
-            bit = image(w, h, BLUE) & 1U;
-            to_decode <<= 1;
-            to_decode ^= (-bit ^ to_decode) & 1U;
-        }
 
-        return to_decode;
+    std::string StegCoding::LSB_decode_min(const std::string &name) {
+        CImg<unsigned char> src(name.c_str());
+        return LSB_decode_min(src);
     }
 
-
-    void encode_length(uint64_t msg_length,
-                       CImg<unsigned char> &image,
-                       const std::function<int(const CImg<unsigned char> &, int)> &f) {
-        int bit, w;
-        int height = image.height();
-
-        // encoding the size to the picture
-        for (int h = 0, j = ENCODE_SIZE - 1;
-             h < height && j >= 0; h++, j--) {
-
-            bit = (msg_length >> j) & 1U; // get the bit at the position
-            w = f(image, h);
-            // changing blue value of the message
-            image(w, h, BLUE) ^= (-bit ^ image(w, h, BLUE)) & 1U;
-        }
+    std::string StegCoding::LSB_decode_min(const CImg<unsigned char> &image) {
+        return LSB_decode_min(image_view(image));
     }
 
+    std::string StegCoding::LSB_decode_min(const PixelView &image) {
+        return decode(image, Method::LSB_MIN);
+    }
 
-    uint64_t decode_length(const CImg<unsigned char> &image,
-                           const std::function<int(const CImg<unsigned char> &, int)> &f) {
-        uint64_t msg_length = 0;
-        int bit, w;
 
-        for (int h = 0; h < ENCODE_SIZE; h++) {
-            msg_length <<= 1;
-            w = f(image, h);
+    // Location policies of the methods, find(image, h, count, columns)
+    // gives the columns of the count pixels used in row h (the ones with
+    // the maximum/minimum red values).
+    struct max_location {
+        static void find(const PixelView &image, int h, int count, int *columns) {
+            row_extrema(image, RED, h, count, true, columns);
+        }
+    };
 
-            bit = image(w, h, BLUE) & 1U;
-            msg_length ^= (-bit ^ msg_length) & 1U;
+    struct min_location {
+        static void find(const PixelView &image, int h, int count, int *columns) {
+            row_extrema(image, RED, h, count, false, columns);
+        }
+    };
+
+    // Finds the columns of the pixels of rows [first, first + rows),
+    // row_pixels in every row, the rows are split between threads when
+    // there are enough pixels in them.
+    template<typename Location>
+    static void find_columns(const PixelView &image, int first, int rows,
+                             int row_pixels, int threads, int *columns) {
+        uint64_t grain = MIN_MAX_GRAIN / image.width + 1;
+        int parts = parallel_parts(rows, grain, threads);
+        if (parts == 1) {
+            for (int h = 0; h < rows; h++)
+                Location::find(image, first + h, row_pixels, columns + (size_t) h * row_pixels);
+            return;
         }
 
-        return msg_length;
+        parallel_for(parts, rows, [&](int, uint64_t begin, uint64_t end) {
+            for (uint64_t h = begin; h < end; h++)
+                Location::find(image, first + (int) h, row_pixels, columns + h * row_pixels);
+        });
     }
 
+    // Cursor over the rows of the image, in each row the pixels
+    // with the maximum (minimum) red values are used. The location
+    // policy is a template parameter, so it is inlined into the
+    // encode/decode loops.
+    //
+    // The columns of every row are found only once for all the channels,
+    // a block of rows at a time, every block as large as all the ones
+    // before it. A short message therefore scans only the first rows,
+    // while a long one is scanned in large blocks split between threads.
+    template<typename Location>
+    class min_max_cursor {
+    public:
+        min_max_cursor(const PixelView &image, int row_pixels, int threads)
+                : image(image), row_pixels(row_pixels), threads(threads),
+                  channel(BLUE), h(0), pixel(0), used(0) {}
+
+        void restart(int new_channel) {
+            channel = new_channel;
+            h = 0;
+            pixel = 0;
+            used = 0;
+        }
 
-    static int find_max_location(const CImg<unsigned char> &image, int height) {
-        int max_loc = 0, max_colour = INT_MIN;
-        for (int w = 0; w < image.width(); w++) {
-            if (image(w, height, RED) > max_colour) {
-                max_colour = image(w, height, RED);
-                max_loc = w;
+        unsigned char &next() {
+            if (pixel == columns.size())
+                more_rows();
+            int w = columns[pixel++];
+            int row = h;
+            if (++used == row_pixels) {
+                used = 0;
+                h++;
             }
+            return image(w, row, channel);
         }
-        return max_loc;
-    }
 
-    static int find_min_location(const CImg<unsigned char> &image, int height) {
-        int min_loc = 0, min_colour = INT_MAX;
-        for (int w = 0; w < image.width(); w++) {
-            if (image(w, height, RED) > min_colour) {
-                min_colour = image(w, height, RED);
-                min_loc = w;
-            }
+    private:
+        void more_rows() {
+            int first = (int) (columns.size() / row_pixels);
+            assert(first < image.height);
+
+            int rows = std::min(std::max(first, MIN_MAX_BLOCK), image.height - first);
+            columns.resize((size_t) (first + rows) * row_pixels);
+            find_columns<Location>(image, first, rows, row_pixels, threads,
+                                   &columns[(size_t) first * row_pixels]);
         }
-        return min_loc;
+
+        const PixelView &image;
+        int row_pixels;
+        int threads;
+        int channel;
+        int h;
+        size_t pixel;       // index of the next column
+        int used;           // pixels of row h used so far
+        std::vector<int> columns;
+    };
+
+    StegOptions min_max_options(const StegOptions &options) {
+        // changing RED would move the pixel chosen in the row
+        StegOptions min_max = options;
+        min_max.channels &= ~CHANNEL_MASK(RED);
+        return min_max;
     }
 
-    static std::string generic_min_max_decode(std::string name,
-                                              const std::function<int(const CImg<unsigned char> &, int)> &f) {
-        CImg<unsigned char> src(name.c_str());
-        uint64_t msg_length = decode_length(src, f);
-        msg_length += ENCODE_SIZE;
-        std::string message = "";
+    uint64_t min_max_samples(int width, int height, const StegOptions &options) {
+        assert(options.row_pixels >= 1);
+        int row_pixels = std::min(options.row_pixels, width);
+        return (uint64_t) height * row_pixels;
+    }
 
-        for (int h = ENCODE_SIZE; h < msg_length && h < src.width(); h += BIT_TO_BYTE) {
-            message += decode_single_byte(src, f, h);
-        }
-        return message;
+    bool decode_min_max(const PixelView &image,
+                        Method method,
+                        const StegOptions &options,
+                        message_output &output) {
+        assert(method == Method::LSB_MAX || method == Method::LSB_MIN);
+        if (method == Method::LSB_MAX)
+            return decode_rows<max_location>(image, method, options, output);
+        return decode_rows<min_location>(image, method, options, output);
     }
 
 
-    static void generic_min_max_encode(std::string name,
-                                       std::string message,
-                                       std::string steg_image,
-                                       const std::function<int(const CImg<unsigned char> &, int)> &f) {
-        CImg<unsigned char> src(name.c_str());
-        uint64_t msg_length = message.length();
+    void encode_min_max(const PixelView &image,
+                        const message_bytes &message,
+                        Method method,
+                        const StegOptions &options) {
+        assert(method == Method::LSB_MAX || method == Method::LSB_MIN);
+        assert(valid_channels(image, options.channels));
 
-        encode_length(msg_length, src, f);
+        if (method == Method::LSB_MAX)
+            encode_rows<max_location>(image, message, method, options);
+        else
+            encode_rows<min_location>(image, message, method, options);
+    }
 
-        int64_t height = ENCODE_SIZE;
-        for (char c : message) {
-            encode_single_byte(c, src, f, height);
-            height += BIT_TO_BYTE;
-        }
+    template<typename Location>
+    static void encode_rows(const PixelView &image, const message_bytes &message,
+                            Method method, const StegOptions &options) {
+        // the same number of pixels is used in each row, so only as much
+        // of the message as there are pixels in the rows is encoded
+        int row_pixels = std::min(options.row_pixels, image.width);
+        encode_planes(min_max_cursor<Location>(image, row_pixels, options.threads),
+                      min_max_samples(image.width, image.height, options), message,
+                      method, min_max_options(options));
+    }
 
-        src.save(steg_image.c_str());
+    template<typename Location>
+    static bool decode_rows(const PixelView &image, Method method,
+                            const StegOptions &options, message_output &output) {
+        int row_pixels = std::min(options.row_pixels, image.width);
+        return decode_planes(min_max_cursor<Location>(image, row_pixels, options.threads),
+                             min_max_samples(image.width, image.height, options),
+                             method, min_max_options(options), output);
     }
 
-}
\ No newline at end of file
+}
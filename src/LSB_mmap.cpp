@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <cctype>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "steganography.h"
+#include "LSB_engine.h"
+#include "LSB_mmap.h"
+
+
+namespace steg {
+
+
+    static bool ppm_view(uint8_t *data, size_t size, PixelView &image);
+
+    static bool bmp_view(uint8_t *data, size_t size, PixelView &image);
+
+    static bool ppm_number(const uint8_t *data, size_t size, size_t &pos, int &number);
+
+    static uint32_t little_endian(const uint8_t *bytes, int count);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    bool StegCoding::encode_mapped(const std::string &name,
+                                   const std::string &message,
+                                   Method method,
+                                   const StegOptions &options) {
+        // the file is not touched if not even the header fits into it
+        mapped_image file;
+        if (!file.open(name, true) || capacity(file.view(), method, options) == 0)
+            return false;
+
+        // the samples are changed right in the file
+        encode(file.view(), message, method, options);
+        return true;
+    }
+
+    std::string StegCoding::decode_mapped(const std::string &name,
+                                          Method method,
+                                          const StegOptions &options) {
+        mapped_image file;
+        if (!file.open(name, false) || !valid_channels(file.view(), options.channels))
+            return "";
+        return decode(file.view(), method, options);
+    }
+
+
+    mapped_image::mapped_image()
+            : fd(-1), data(nullptr), size(0), image(nullptr, 0, 0, 0, 0) {}
+
+    mapped_image::~mapped_image() {
+        if (data)
+            munmap(data, size);
+        if (fd >= 0)
+            close(fd);
+    }
+
+    bool mapped_image::open(const std::string &name, bool writable) {
+        fd = ::open(name.c_str(), writable ? O_RDWR : O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+            return false;
+
+        // a shared mapping, so the changed pages go back to the file
+        size = (size_t) info.st_size;
+        void *mapped = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                            MAP_SHARED, fd, 0);
+        if (mapped == MAP_FAILED)
+            return false;
+        data = static_cast<uint8_t *>(mapped);
+
+        return ppm_view(data, size, image) || bmp_view(data, size, image);
+    }
+
+
+    // Binary PPM: "P6", width, height and the largest value (below 256)
+    // as text separated by whitespace (and comments), a single whitespace
+    // and then the RGB pixels row by row.
+    static bool ppm_view(uint8_t *data, size_t size, PixelView &image) {
+        if (size < 2 || data[0] != 'P' || data[1] != '6')
+            return false;
+
+        size_t pos = 2;
+        int width, height, max_value;
+        if (!ppm_number(data, size, pos, width) || !ppm_number(data, size, pos, height) ||
+            !ppm_number(data, size, pos, max_value))
+            return false;
+        if (width == 0 || height == 0 || max_value == 0 || max_value > 255 || pos >= size)
+            return false;
+
+        pos++;
+        uint64_t stride = (uint64_t) width * 3;
+        if (size - pos < stride * height)
+            return false;
+
+        image = PixelView(data + pos, width, height, 3, stride);
+        return true;
+    }
+
+    // Reads the next number of the PPM header starting at pos, skipping
+    // the whitespace and comments before it.
+    static bool ppm_number(const uint8_t *data, size_t size, size_t &pos, int &number) {
+        while (pos < size && (isspace(data[pos]) || data[pos] == '#')) {
+            if (data[pos] == '#') {
+                while (pos < size && data[pos] != '\n')
+                    pos++;
+            } else {
+                pos++;
+            }
+        }
+
+        if (pos == size || !isdigit(data[pos]))
+            return false;
+        int64_t value = 0;
+        while (pos < size && isdigit(data[pos])) {
+            value = value * 10 + (data[pos++] - '0');
+            if (value > 0x7fffffff)
+                return false;
+        }
+        number = (int) value;
+        return pos < size && isspace(data[pos]);
+    }
+
+    // Uncompressed BMP with 24 (BGR) or 32 (BGRX) bits per pixel. Rows are
+    // padded to 4 bytes and stored from the bottom one up, unless the
+    // height is negative, which the stride of the view takes care of.
+    static bool bmp_view(uint8_t *data, size_t size, PixelView &image) {
+        const size_t header_size = 54;
+        if (size < header_size || data[0] != 'B' || data[1] != 'M')
+            return false;
+
+        uint32_t offset = little_endian(data + 10, 4);
+        uint32_t info_size = little_endian(data + 14, 4);
+        int32_t width = (int32_t) little_endian(data + 18, 4);
+        int32_t height = (int32_t) little_endian(data + 22, 4);
+        uint32_t bits = little_endian(data + 28, 2);
+        uint32_t compression = little_endian(data + 30, 4);
+        if (info_size < 40 || compression != 0 || (bits != 24 && bits != 32))
+            return false;
+        if (width <= 0 || height == 0 || height == INT32_MIN)
+            return false;
+
+        bool top_down = height < 0;
+        if (top_down)
+            height = -height;
+        int64_t stride = ((int64_t) width * bits + 31) / 32 * 4;
+        if (offset > size || size - offset < (uint64_t) stride * height)
+            return false;
+
+        // the channels of every pixel are in the reverse (BGR) order
+        uint8_t *first_row = data + offset + (top_down ? 0 : stride * (height - 1));
+        image = PixelView(first_row + 2, width, height, 3, top_down ? stride : -stride);
+        image.pixel_step = bits / BIT_TO_BYTE;
+        image.channel_step = -1;
+        return true;
+    }
+
+    static uint32_t little_endian(const uint8_t *bytes, int count) {
+        uint32_t value = 0;
+        for (int i = count - 1; i >= 0; i--)
+            value = (value << BIT_TO_BYTE) | bytes[i];
+        return value;
+    }
+
+}
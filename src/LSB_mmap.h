@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_MMAP_H
+#define IMAGE_STEGANOGRPAHY_LSB_MMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "steganography.h"
+
+namespace steg {
+
+    // An uncompressed image file mapped into memory, so the pixels are
+    // used straight from the file: encoding changes only the samples
+    // holding the message and only the pages with them are written back.
+    // Binary PPM (P6, 8 bit) and BMP (24 or 32 bit, uncompressed) files
+    // are supported.
+    class mapped_image {
+    public:
+        mapped_image();
+
+        ~mapped_image();
+
+        // maps the file (for writing if writable), returns false if it
+        // can not be mapped or is not one of the supported formats
+        bool open(const std::string &name, bool writable);
+
+        // the pixels of the file, valid while the file is mapped
+        const PixelView &view() const {
+            return image;
+        }
+
+    private:
+        int fd;
+        uint8_t *data;
+        size_t size;
+        PixelView image;
+
+        mapped_image(const mapped_image &);
+
+        mapped_image &operator=(const mapped_image &);
+    };
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_MMAP_H
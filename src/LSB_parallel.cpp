@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <thread>
+#include <vector>
+#include "LSB_parallel.h"
+
+
+namespace steg {
+
+
+    int parallel_parts(uint64_t count, uint64_t grain, int threads) {
+        if (threads <= 0)
+            threads = (int) std::thread::hardware_concurrency();
+        if (threads <= 1 || count < 2 * grain)
+            return 1;
+
+        uint64_t parts = count / grain;
+        return parts < (uint64_t) threads ? (int) parts : threads;
+    }
+
+    void parallel_for(int parts, uint64_t count,
+                      const std::function<void(int, uint64_t, uint64_t)> &f) {
+        std::vector<std::thread> workers;
+        workers.reserve(parts - 1);
+        for (int part = 1; part < parts; part++) {
+            workers.emplace_back(f, part, count * part / parts, count * (part + 1) / parts);
+        }
+
+        f(0, 0, count / parts);
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+}
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_PARALLEL_H
+#define IMAGE_STEGANOGRPAHY_LSB_PARALLEL_H
+
+#include <cstdint>
+#include <functional>
+
+namespace steg {
+
+    // Splitting of a large amount of work between threads. The work is
+    // only split when every thread gets at least grain items, below that
+    // starting the threads costs more than it saves.
+
+    // Smallest number of message bytes worth a thread of its own, the
+    // bits of 256 KiB of message are spread over 2 million samples.
+#define PARALLEL_GRAIN (256 * 1024)
+
+    // Number of parts (threads) to split count items into, at most
+    // threads parts (0 meaning the number of cores), and 1 if count is
+    // too small to be split.
+    int parallel_parts(uint64_t count, uint64_t grain, int threads);
+
+    // Calls f(part, begin, end) for every part of [0, count) split into
+    // parts consecutive ranges, each on its own thread (the calling thread
+    // takes the first part), and waits until all of them are done.
+    void parallel_for(int parts, uint64_t count,
+                      const std::function<void(int, uint64_t, uint64_t)> &f);
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_PARALLEL_H
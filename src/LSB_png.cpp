@@ -0,0 +1,414 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <cstring>
+#include <vector>
+#include <fstream>
+#include <png.h>
+#include "steganography.h"
+#include "LSB_png.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "CImg.h"
+
+using namespace cimg_library;
+
+
+namespace steg {
+
+
+    struct png_reader {
+        const uint8_t *data;
+        size_t size;
+        size_t pos;
+    };
+
+    static void read_from_buffer(png_structp png_ptr, png_bytep out, png_size_t length);
+
+    static void write_to_buffer(png_structp png_ptr, png_bytep in, png_size_t length);
+
+    static void flush_buffer(png_structp png_ptr);
+
+    static void png_error_handler(png_structp png_ptr, png_const_charp message);
+
+    static void png_warning_handler(png_structp png_ptr, png_const_charp message);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    std::vector<uint8_t> StegCoding::encode_to_png_buffer(const uint8_t *png,
+                                                          size_t size,
+                                                          const std::string &message,
+                                                          Method method,
+                                                          const StegOptions &options) {
+        std::vector<uint8_t> stego_png;
+        CImg<unsigned char> src;
+        if (!png_buffer_to_image(png, size, src))
+            return stego_png;
+
+        // the image might not have the channels asked for or be too
+        // small for the header
+        PixelView image = image_view(src);
+        if (capacity(image, method, options) == 0)
+            return stego_png;
+        encode(image, message, method, options);
+
+        if (!image_to_png_buffer(image, stego_png))
+            stego_png.clear();
+        return stego_png;
+    }
+
+    std::string StegCoding::decode_from_png_buffer(const uint8_t *png,
+                                                   size_t size,
+                                                   Method method,
+                                                   const StegOptions &options) {
+        CImg<unsigned char> src;
+        if (!png_buffer_to_image(png, size, src))
+            return "";
+
+        return decode(image_view(src), method, options);
+    }
+
+
+    bool png_buffer_to_image(const uint8_t *png, size_t size,
+                             CImg<unsigned char> &image) {
+        if (size < 8 || png_sig_cmp(png, 0, 8) != 0)
+            return false;
+
+        png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr,
+                                                     png_error_handler,
+                                                     png_warning_handler);
+        if (!png_ptr)
+            return false;
+        png_infop info_ptr = png_create_info_struct(png_ptr);
+        if (!info_ptr) {
+            png_destroy_read_struct(&png_ptr, nullptr, nullptr);
+            return false;
+        }
+
+        png_reader reader{png, size, 0};
+        std::vector<unsigned char> pixels;
+        std::vector<png_bytep> rows;
+
+        // libpng jumps back here on any error in the data
+        if (setjmp(png_jmpbuf(png_ptr))) {
+            png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+            return false;
+        }
+
+        png_set_read_fn(png_ptr, &reader, read_from_buffer);
+        png_read_info(png_ptr, info_ptr);
+
+        // everything is read as 8 bit RGB or RGBA
+        png_set_expand(png_ptr);
+        png_set_strip_16(png_ptr);
+        png_set_gray_to_rgb(png_ptr);
+        int passes = png_set_interlace_handling(png_ptr);
+        png_read_update_info(png_ptr, info_ptr);
+
+        int width = png_get_image_width(png_ptr, info_ptr);
+        int height = png_get_image_height(png_ptr, info_ptr);
+        int channels = png_get_channels(png_ptr, info_ptr);
+        image.assign(width, height, 1, channels);
+        PixelView planes = image_view(image);
+
+        if (passes == 1) {
+            // rows are scattered into the CImg planes one by one,
+            // so only a single interleaved row is kept in memory
+            pixels.resize((size_t) width * channels);
+            PixelView row(pixels.data(), width, 1, channels, 0);
+            for (int h = 0; h < height; h++) {
+                png_read_row(png_ptr, pixels.data(), nullptr);
+                for (int c = 0; c < channels; c++)
+                    for (int w = 0; w < width; w++)
+                        planes(w, h, c) = row(w, 0, c);
+            }
+        } else {
+            // interlaced image is only complete after the last pass
+            pixels.resize((size_t) width * height * channels);
+            rows.resize(height);
+            for (int h = 0; h < height; h++)
+                rows[h] = &pixels[(size_t) h * width * channels];
+            png_read_image(png_ptr, rows.data());
+
+            PixelView all(pixels.data(), width, height, channels, (int64_t) width * channels);
+            for (int c = 0; c < channels; c++)
+                for (int h = 0; h < height; h++)
+                    for (int w = 0; w < width; w++)
+                        planes(w, h, c) = all(w, h, c);
+        }
+
+        png_read_end(png_ptr, nullptr);
+        png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+        return true;
+    }
+
+    bool image_to_png_buffer(const PixelView &image, std::vector<uint8_t> &png) {
+        static const int colour_types[] = {PNG_COLOR_TYPE_GRAY, PNG_COLOR_TYPE_GRAY_ALPHA,
+                                           PNG_COLOR_TYPE_RGB, PNG_COLOR_TYPE_RGB_ALPHA};
+        if (image.channels < 1 || image.channels > 4)
+            return false;
+
+        png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
+                                                      png_error_handler,
+                                                      png_warning_handler);
+        if (!png_ptr)
+            return false;
+        png_infop info_ptr = png_create_info_struct(png_ptr);
+        if (!info_ptr) {
+            png_destroy_write_struct(&png_ptr, nullptr);
+            return false;
+        }
+
+        std::vector<unsigned char> pixels((size_t) image.width * image.channels);
+        PixelView row(pixels.data(), image.width, 1, image.channels, 0);
+
+        if (setjmp(png_jmpbuf(png_ptr))) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            return false;
+        }
+
+        png_set_write_fn(png_ptr, &png, write_to_buffer, flush_buffer);
+        png_set_IHDR(png_ptr, info_ptr, image.width, image.height, 8,
+                     colour_types[image.channels - 1], PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_ptr, info_ptr);
+
+        // rows are interleaved one by one, whatever the layout of the image
+        for (int h = 0; h < image.height; h++) {
+            for (int c = 0; c < image.channels; c++)
+                for (int w = 0; w < image.width; w++)
+                    row(w, 0, c) = image(w, h, c);
+            png_write_row(png_ptr, pixels.data());
+        }
+
+        png_write_end(png_ptr, info_ptr);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return true;
+    }
+
+
+    bool png_file_info(const std::string &name, int &width, int &height, int &channels) {
+        // signature (8 bytes), then the IHDR chunk: length (4), type (4),
+        // width (4), height (4), bit depth (1), colour type (1), ...
+        uint8_t head[26];
+        std::ifstream file(name.c_str(), std::ios::binary);
+        if (!file.read(reinterpret_cast<char *>(head), sizeof(head)))
+            return false;
+        if (png_sig_cmp(head, 0, 8) != 0 || std::memcmp(head + 12, "IHDR", 4) != 0)
+            return false;
+
+        uint32_t w = png_get_uint_32(head + 16);
+        uint32_t h = png_get_uint_32(head + 20);
+        if (w == 0 || h == 0 || w > PNG_UINT_31_MAX || h > PNG_UINT_31_MAX)
+            return false;
+
+        // the same expansion as png_buffer_to_image: gray becomes RGB,
+        // a tRNS chunk of an image without alpha adds the alpha channel
+        bool alpha;
+        switch (head[25]) {
+            case PNG_COLOR_TYPE_GRAY:
+            case PNG_COLOR_TYPE_RGB:
+            case PNG_COLOR_TYPE_PALETTE:
+                alpha = false;
+                break;
+            case PNG_COLOR_TYPE_GRAY_ALPHA:
+            case PNG_COLOR_TYPE_RGB_ALPHA:
+                alpha = true;
+                break;
+            default:
+                return false;
+        }
+
+        // tRNS comes before the image data, only the chunk headers up to
+        // the first IDAT are read, skipping the rest of the IHDR first
+        file.seekg(8 + 8 + 13 + 4);
+        uint8_t chunk[8];
+        while (!alpha) {
+            if (!file.read(reinterpret_cast<char *>(chunk), sizeof(chunk)))
+                return false;
+            if (std::memcmp(chunk + 4, "IDAT", 4) == 0 || std::memcmp(chunk + 4, "IEND", 4) == 0)
+                break;
+            if (std::memcmp(chunk + 4, "tRNS", 4) == 0)
+                alpha = true;
+            // the data and the crc of the chunk
+            file.seekg((std::streamoff) png_get_uint_32(chunk) + 4, std::ios::cur);
+        }
+
+        width = (int) w;
+        height = (int) h;
+        channels = alpha ? 4 : 3;
+        return true;
+    }
+
+
+    png_row_reader::png_row_reader()
+            : width(0), height(0), channels(0),
+              file(nullptr), png_ptr(nullptr), info_ptr(nullptr) {}
+
+    png_row_reader::~png_row_reader() {
+        close();
+    }
+
+    void png_row_reader::close() {
+        if (png_ptr)
+            png_destroy_read_struct(&png_ptr, info_ptr ? &info_ptr : nullptr, nullptr);
+        if (file)
+            fclose(file);
+        file = nullptr;
+        png_ptr = nullptr;
+        info_ptr = nullptr;
+    }
+
+    bool png_row_reader::open(const std::string &name) {
+        close();
+        file = fopen(name.c_str(), "rb");
+        if (!file)
+            return false;
+
+        uint8_t signature[8];
+        if (fread(signature, 1, sizeof(signature), file) != sizeof(signature) ||
+            png_sig_cmp(signature, 0, sizeof(signature)) != 0)
+            return false;
+
+        png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr,
+                                         png_error_handler, png_warning_handler);
+        if (!png_ptr)
+            return false;
+        info_ptr = png_create_info_struct(png_ptr);
+        if (!info_ptr)
+            return false;
+
+        if (setjmp(png_jmpbuf(png_ptr)))
+            return false;
+
+        png_init_io(png_ptr, file);
+        png_set_sig_bytes(png_ptr, sizeof(signature));
+        png_read_info(png_ptr, info_ptr);
+
+        // the same rows as png_buffer_to_image gives
+        png_set_expand(png_ptr);
+        png_set_strip_16(png_ptr);
+        png_set_gray_to_rgb(png_ptr);
+        if (png_set_interlace_handling(png_ptr) != 1)
+            return false;
+        png_read_update_info(png_ptr, info_ptr);
+
+        width = png_get_image_width(png_ptr, info_ptr);
+        height = png_get_image_height(png_ptr, info_ptr);
+        channels = png_get_channels(png_ptr, info_ptr);
+        return true;
+    }
+
+    bool png_row_reader::read_row(unsigned char *row) {
+        if (setjmp(png_jmpbuf(png_ptr)))
+            return false;
+        png_read_row(png_ptr, row, nullptr);
+        return true;
+    }
+
+
+    png_row_writer::png_row_writer()
+            : file(nullptr), png_ptr(nullptr), info_ptr(nullptr) {}
+
+    png_row_writer::~png_row_writer() {
+        if (png_ptr)
+            png_destroy_write_struct(&png_ptr, info_ptr ? &info_ptr : nullptr);
+        if (file)
+            fclose(file);
+    }
+
+    bool png_row_writer::open(const std::string &name, int width, int height, int channels) {
+        if (channels != 3 && channels != 4)
+            return false;
+
+        file = fopen(name.c_str(), "wb");
+        if (!file)
+            return false;
+
+        png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr,
+                                          png_error_handler, png_warning_handler);
+        if (!png_ptr)
+            return false;
+        info_ptr = png_create_info_struct(png_ptr);
+        if (!info_ptr)
+            return false;
+
+        if (setjmp(png_jmpbuf(png_ptr)))
+            return false;
+
+        png_init_io(png_ptr, file);
+        png_set_IHDR(png_ptr, info_ptr, width, height, 8,
+                     channels == 3 ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGB_ALPHA,
+                     PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                     PNG_FILTER_TYPE_DEFAULT);
+        png_write_info(png_ptr, info_ptr);
+        return true;
+    }
+
+    bool png_row_writer::write_row(const unsigned char *row) {
+        if (setjmp(png_jmpbuf(png_ptr)))
+            return false;
+        png_write_row(png_ptr, row);
+        return true;
+    }
+
+    bool png_row_writer::finish() {
+        if (setjmp(png_jmpbuf(png_ptr)))
+            return false;
+        png_write_end(png_ptr, info_ptr);
+        return fflush(file) == 0;
+    }
+
+
+    static void read_from_buffer(png_structp png_ptr, png_bytep out, png_size_t length) {
+        png_reader *reader = static_cast<png_reader *>(png_get_io_ptr(png_ptr));
+        if (reader->size - reader->pos < length)
+            png_error(png_ptr, "unexpected end of PNG data");
+
+        std::memcpy(out, reader->data + reader->pos, length);
+        reader->pos += length;
+    }
+
+    static void write_to_buffer(png_structp png_ptr, png_bytep in, png_size_t length) {
+        std::vector<uint8_t> *png = static_cast<std::vector<uint8_t> *>(png_get_io_ptr(png_ptr));
+        png->insert(png->end(), in, in + length);
+    }
+
+    static void flush_buffer(png_structp) {
+    }
+
+    // invalid data is reported by the return values, nothing is printed
+    static void png_error_handler(png_structp png_ptr, png_const_charp) {
+        png_longjmp(png_ptr, 1);
+    }
+
+    static void png_warning_handler(png_structp, png_const_charp) {
+    }
+
+}
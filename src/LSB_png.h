@@ -0,0 +1,121 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_PNG_H
+#define IMAGE_STEGANOGRPAHY_LSB_PNG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <png.h>
+#include "steganography.h"
+
+namespace steg {
+
+    // PNG encoding/decoding in memory using libpng, without going
+    // through the files as CImg load/save does.
+
+    // Decodes the PNG file bytes (png, size) into image, which is
+    // (re)allocated as width x height image with 3 (RGB) or 4 (RGBA)
+    // channels. Returns false if png is not a valid PNG image.
+    bool png_buffer_to_image(const uint8_t *png, size_t size,
+                             cimg_library::CImg<unsigned char> &image);
+
+    // Encodes image (1 to 4 channels, any layout) as PNG file bytes
+    // appended to png. Returns false if the image could not be encoded.
+    bool image_to_png_buffer(const PixelView &image, std::vector<uint8_t> &png);
+
+    // Reads only the headers of the PNG file (IHDR and the chunk headers
+    // before the image data), giving the size of the image and the number
+    // of channels png_buffer_to_image loads it with (3, or 4 with alpha
+    // or a tRNS chunk), without decoding any of the pixels. Returns false
+    // if the file is not a PNG image.
+    bool png_file_info(const std::string &name, int &width, int &height, int &channels);
+
+    // Reads a PNG file one row at a time, as 8 bit RGB or RGBA rows of
+    // interleaved samples, so only a single row has to be in memory.
+    // Interlaced images can not be read this way.
+    class png_row_reader {
+    public:
+        png_row_reader();
+
+        ~png_row_reader();
+
+        // opens the file and reads its header, returns false if it is
+        // not a non-interlaced PNG image
+        bool open(const std::string &name);
+
+        // stops reading, the rest of the file is not decompressed
+        void close();
+
+        // reads the next row into row (width * channels bytes)
+        bool read_row(unsigned char *row);
+
+        int width;
+        int height;
+        int channels;
+
+    private:
+        FILE *file;
+        png_structp png_ptr;
+        png_infop info_ptr;
+
+        png_row_reader(const png_row_reader &);
+
+        png_row_reader &operator=(const png_row_reader &);
+    };
+
+    // Writes a 8 bit PNG file one row at a time.
+    class png_row_writer {
+    public:
+        png_row_writer();
+
+        ~png_row_writer();
+
+        // creates the file and writes the header for an image of the
+        // given size with 3 (RGB) or 4 (RGBA) channels
+        bool open(const std::string &name, int width, int height, int channels);
+
+        // writes the next row (width * channels interleaved samples)
+        bool write_row(const unsigned char *row);
+
+        // writes the end of the image, all the rows have to be written
+        bool finish();
+
+    private:
+        FILE *file;
+        png_structp png_ptr;
+        png_infop info_ptr;
+
+        png_row_writer(const png_row_writer &);
+
+        png_row_writer &operator=(const png_row_writer &);
+    };
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_PNG_H
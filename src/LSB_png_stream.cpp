@@ -0,0 +1,281 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <assert.h>
+#include "steganography.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_png.h"
+
+
+namespace steg {
+
+
+    static bool encode_rows(png_row_reader &reader, png_row_writer &writer,
+                            const stream_bits &stream, Method method,
+                            uint64_t samples, const StegOptions &options);
+
+    static uint64_t method_samples(Method method, uint64_t total_pixels);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    bool StegCoding::encode_png_stream(const std::string &name,
+                                       const std::string &message,
+                                       const std::string &stego_image,
+                                       Method method,
+                                       const StegOptions &options) {
+        if (method != Method::LSB && method != Method::LSB_ODD && method != Method::LSB_EVEN)
+            return false;
+
+        png_row_reader reader;
+        if (!reader.open(name) || (options.channels >> reader.channels) != 0 ||
+            options.channels == 0)
+            return false;
+
+        uint64_t samples = method_samples(method, (uint64_t) reader.width * reader.height);
+
+        uint8_t flags = header_flags(options);
+        uint64_t all_samples = samples * channel_count(options.channels);
+        if (all_samples * options.bits < (HEADER_MIN_SIZE + trailer_size(flags)) * BIT_TO_BYTE)
+            return false;
+
+        // the same stream encode_stream writes
+        uint64_t msg_length = message.length();
+        uint64_t capacity = stream_capacity(all_samples, options.bits, flags);
+        if (msg_length > capacity)
+            msg_length = capacity;
+
+        const uint8_t *payload = reinterpret_cast<const uint8_t *>(message.data());
+        uint8_t header[HEADER_MAX_SIZE];
+        size_t size = write_header(StegHeader{method, flags, msg_length}, header);
+        uint8_t trailer[CRC32C_SIZE];
+        if (flags & HEADER_FLAG_CRC32C)
+            store_crc32c(crc32c(0, payload, msg_length), trailer);
+        stream_bits stream(header, size, payload, msg_length, trailer, trailer_size(flags));
+
+        // The image is written into a new file next to stego_image,
+        // which replaces stego_image only once the whole image is written,
+        // so stego_image may be the image read (or a link to it) and no
+        // partially written image is ever left behind.
+        // It gets the permissions of the file it replaces, or of the
+        // image read for a new file, instead of the private ones of
+        // mkstemp.
+        struct stat info;
+        if (stat(stego_image.c_str(), &info) != 0 && stat(name.c_str(), &info) != 0)
+            return false;
+        std::string temporary = stego_image + ".XXXXXX";
+        int fd = mkstemp(&temporary[0]);
+        if (fd < 0)
+            return false;
+        fchmod(fd, info.st_mode & 07777);
+        close(fd);
+
+        bool encoded;
+        {
+            png_row_writer writer;
+            encoded = writer.open(temporary, reader.width, reader.height, reader.channels) &&
+                      encode_rows(reader, writer, stream, method, samples, options) &&
+                      writer.finish();
+        }
+
+        if (encoded && std::rename(temporary.c_str(), stego_image.c_str()) == 0)
+            return true;
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+
+    // Every row is read, the samples of the row holding the stream are
+    // changed in all the channels, and the row is written right away.
+    static bool encode_rows(png_row_reader &reader, png_row_writer &writer,
+                            const stream_bits &stream, Method method,
+                            uint64_t samples, const StegOptions &options) {
+        int width = reader.width;
+        int channels = reader.channels;
+        int step = method == Method::LSB ? 1 : 2;
+        int offset = method == Method::LSB_ODD ? 1 : 0;
+
+        std::vector<unsigned char> row((size_t) width * channels);
+        for (int h = 0; h < reader.height; h++) {
+            if (!reader.read_row(row.data()))
+                return false;
+
+            // first pixel of the row used by the method, and its number
+            // among the pixels used by the method
+            uint64_t pixel = (uint64_t) h * width;
+            int first = (int) ((offset + step - pixel % step) % step);
+            uint64_t number = (pixel + first - offset) / step;
+
+            int plane = 0;
+            for (int c = 0; c < channels; c++) {
+                if (!(options.channels & CHANNEL_MASK(c)))
+                    continue;
+
+                uint64_t sample = plane++ * samples + number;
+                if (sample * options.bits >= stream.size())
+                    continue;
+                for (int w = first; w < width; w += step, sample++)
+                    put_stream_sample(stream, sample, options.bits, row[(size_t) w * channels + c]);
+            }
+
+            if (!writer.write_row(row.data()))
+                return false;
+        }
+        return true;
+    }
+
+
+
+    std::string StegCoding::decode_png_stream(const std::string &name,
+                                              Method method,
+                                              const StegOptions &options) {
+        std::string message;
+        if (method != Method::LSB && method != Method::LSB_ODD && method != Method::LSB_EVEN)
+            return message;
+        decode_png_rows(name, method, options, message);
+        return message;
+    }
+
+
+    // The rows of the PNG file read so far, only the last one is kept.
+    class png_rows {
+    public:
+        explicit png_rows(const std::string &name)
+                : name(name), row_number(-1), failed(false), dummy(0) {}
+
+        bool open() {
+            row_number = -1;
+            if (!reader.open(name))
+                return false;
+            row.resize((size_t) reader.width * reader.channels);
+            return true;
+        }
+
+        // Row h, reading the rows up to it. Going back to an earlier row
+        // (for the next channel) starts again from the beginning of the
+        // file. Gives a row of zeros after a read error.
+        const unsigned char *get(int h) {
+            if (h < row_number && !open())
+                failed = true;
+            while (!failed && row_number < h) {
+                if (!reader.read_row(row.data()))
+                    failed = true;
+                row_number++;
+            }
+            if (failed)
+                std::fill(row.begin(), row.end(), 0);
+            return row.data();
+        }
+
+        png_row_reader reader;
+        std::string name;
+        std::vector<unsigned char> row;
+        int row_number;
+        bool failed;
+        unsigned char dummy;
+    };
+
+    // Cursor over the pixels first, first + step, first + 2 * step, ...
+    // of a channel of the PNG file, the rows are decompressed only when
+    // the cursor gets to them.
+    class png_row_cursor {
+    public:
+        png_row_cursor(png_rows &rows, uint64_t first, int step)
+                : rows(rows), first(first), step(step),
+                  channel(BLUE), w(0), h(0) {
+            restart(BLUE);
+        }
+
+        void restart(int new_channel) {
+            channel = new_channel;
+            w = first % rows.reader.width;
+            h = first / rows.reader.width;
+        }
+
+        unsigned char &next() {
+            // the samples are only read, the copy keeps the row intact
+            rows.dummy = rows.get(h)[(size_t) w * rows.reader.channels + channel];
+            w += step;
+            while (w >= rows.reader.width) {
+                w -= rows.reader.width;
+                h++;
+            }
+            return rows.dummy;
+        }
+
+    private:
+        png_rows &rows;
+        uint64_t first;
+        int step;
+        int channel;
+        int w;
+        int h;
+    };
+
+    bool decode_png_rows(const std::string &name, Method method,
+                         const StegOptions &options, std::string &message) {
+        assert(method == Method::LSB || method == Method::LSB_ODD || method == Method::LSB_EVEN);
+
+        png_rows rows(name);
+        if (!rows.open())
+            return false;
+
+        message.clear();
+        if (options.channels == 0 || (options.channels >> rows.reader.channels) != 0)
+            return true;
+
+        // decode_stream stops asking for samples after the end of the
+        // message, so the rest of the rows is never decompressed
+        int step = method == Method::LSB ? 1 : 2;
+        int offset = method == Method::LSB_ODD ? 1 : 0;
+        uint64_t samples = method_samples(method, (uint64_t) rows.reader.width * rows.reader.height);
+        message_output output(message);
+        if (!decode_planes(png_row_cursor(rows, offset, step), samples, method, options, output) ||
+            rows.failed)
+            message.clear();
+        return true;
+    }
+
+
+    // samples of a single channel used by the method
+    static uint64_t method_samples(Method method, uint64_t total_pixels) {
+        if (method == Method::LSB_ODD)
+            return total_pixels / 2;
+        if (method == Method::LSB_EVEN)
+            return (total_pixels + 1) / 2;
+        return total_pixels;
+    }
+
+}
@@ -0,0 +1,216 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include "LSB_primes.h"
+#include "LSB_parallel.h"
+
+
+namespace steg {
+
+
+    static std::vector<int64_t> base_primes(int64_t limit);
+
+    static void sieve_segment(const std::vector<int64_t> &base, int64_t low,
+                              int64_t count, uint64_t *composite);
+
+    static void segment_primes(const uint64_t *composite, int64_t low, int64_t count,
+                               std::vector<int64_t> &primes);
+
+    static int64_t segment_count(const uint64_t *composite, int64_t count);
+
+
+    //*****************************************************************
+    //*****************************************************************
+    //*****************************************************************
+
+
+    std::vector<int64_t> primes(int64_t limit, int threads) {
+        std::vector<int64_t> primes;
+        if (limit <= 2)
+            return primes;
+        primes.push_back(2);
+
+        // the odd numbers 3, 5, ... below the limit, in segments
+        int64_t odd_count = (limit - 2) / 2;
+        int64_t segments = (odd_count + PRIME_LIST_SEGMENT - 1) / PRIME_LIST_SEGMENT;
+        std::vector<int64_t> base = base_primes(limit);
+
+        // every thread sieves a run of the segments into its own list,
+        // the lists are joined in the order of the runs
+        int parts = parallel_parts(segments, PRIME_GRAIN, threads);
+        std::vector<std::vector<int64_t>> found(parts);
+        parallel_for(parts, segments, [&](int part, uint64_t begin, uint64_t end) {
+            std::vector<uint64_t> composite(PRIME_LIST_SEGMENT / 64);
+            for (uint64_t s = begin; s < end; s++) {
+                int64_t first = s * PRIME_LIST_SEGMENT;
+                int64_t count = std::min<int64_t>(PRIME_LIST_SEGMENT, odd_count - first);
+                sieve_segment(base, 3 + 2 * first, count, composite.data());
+                segment_primes(composite.data(), 3 + 2 * first, count, found[part]);
+            }
+        });
+
+        for (const auto &part : found)
+            primes.insert(primes.end(), part.begin(), part.end());
+        return primes;
+    }
+
+    int64_t prime_count(int64_t limit, int threads) {
+        if (limit <= 2)
+            return 0;
+
+        // the same segments as primes() gives, each thread counting the
+        // primes of its run of segments
+        int64_t odd_count = (limit - 2) / 2;
+        int64_t segments = (odd_count + PRIME_LIST_SEGMENT - 1) / PRIME_LIST_SEGMENT;
+        std::vector<int64_t> base = base_primes(limit);
+
+        int parts = parallel_parts(segments, PRIME_GRAIN, threads);
+        std::vector<int64_t> found(parts);
+        parallel_for(parts, segments, [&](int part, uint64_t begin, uint64_t end) {
+            std::vector<uint64_t> composite(PRIME_LIST_SEGMENT / 64);
+            for (uint64_t s = begin; s < end; s++) {
+                int64_t first = s * PRIME_LIST_SEGMENT;
+                int64_t count = std::min<int64_t>(PRIME_LIST_SEGMENT, odd_count - first);
+                sieve_segment(base, 3 + 2 * first, count, composite.data());
+                found[part] += segment_count(composite.data(), count);
+            }
+        });
+
+        int64_t count = 1;  // 2
+        for (int64_t part : found)
+            count += part;
+        return count;
+    }
+
+
+    prime_generator::prime_generator(int64_t limit)
+            : limit(limit), base(base_primes(limit)),
+              segment(PRIME_SEGMENT / 64), low(3), pos(0), two(true) {
+        sieve_segment(base, low, PRIME_SEGMENT, segment.data());
+    }
+
+    int64_t prime_generator::next() {
+        if (two) {
+            two = false;
+            return limit > 2 ? 2 : -1;
+        }
+
+        while (true) {
+            if (pos == PRIME_SEGMENT) {
+                low += 2 * PRIME_SEGMENT;
+                pos = 0;
+                sieve_segment(base, low, PRIME_SEGMENT, segment.data());
+            }
+            int64_t n = low + 2 * pos;
+            if (n >= limit)
+                return -1;
+            bool composite = (segment[pos / 64] >> (pos % 64)) & 1;
+            pos++;
+            if (!composite)
+                return n;
+        }
+    }
+
+    int64_t prime_count_lower_bound(int64_t limit) {
+        // pi(x) > x / ln(x) for x >= 17 (Rosser and Schoenfeld), the
+        // primes are below the limit so x is limit - 1
+        int64_t x = limit - 1;
+        if (x < 17)
+            return 0;
+        return (int64_t) ((double) x / std::log((double) x)) - 1;
+    }
+
+
+    // the odd primes up to the square root of the limit, which are
+    // enough to sieve all the numbers below the limit
+    static std::vector<int64_t> base_primes(int64_t limit) {
+        int64_t root = (int64_t) std::sqrt((double) limit);
+        while (root * root > limit)
+            root--;
+        while ((root + 1) * (root + 1) <= limit)
+            root++;
+
+        std::vector<int64_t> base;
+        std::vector<bool> composite(root + 1, false);
+        for (int64_t i = 3; i <= root; i += 2) {
+            if (composite[i])
+                continue;
+            base.push_back(i);
+            for (int64_t j = i * i; j <= root; j += 2 * i)
+                composite[j] = true;
+        }
+        return base;
+    }
+
+    // Marks the composite numbers among the count odd numbers low, low + 2,
+    // ... (low is odd), bit i of composite standing for low + 2 * i.
+    static void sieve_segment(const std::vector<int64_t> &base, int64_t low,
+                              int64_t count, uint64_t *composite) {
+        std::fill(composite, composite + (count + 63) / 64, 0);
+        int64_t high = low + 2 * count;
+        for (int64_t p : base) {
+            if (p * p >= high)
+                break;
+
+            // the first odd multiple of p in the segment, p itself is not
+            // crossed out as the crossing starts at p * p
+            int64_t first = std::max(p * p, (low + p - 1) / p * p);
+            if (first % 2 == 0)
+                first += p;
+            for (int64_t i = (first - low) / 2; i < count; i += p)
+                composite[i / 64] |= (uint64_t) 1 << (i % 64);
+        }
+    }
+
+    // adds the numbers not marked as composite to primes
+    static void segment_primes(const uint64_t *composite, int64_t low, int64_t count,
+                               std::vector<int64_t> &primes) {
+        for (int64_t word = 0; word * 64 < count; word++) {
+            uint64_t bits = ~composite[word];
+            if (count - word * 64 < 64)
+                bits &= ((uint64_t) 1 << (count - word * 64)) - 1;
+            while (bits) {
+                int bit = __builtin_ctzll(bits);
+                primes.push_back(low + 2 * (word * 64 + bit));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // number of the numbers not marked as composite
+    static int64_t segment_count(const uint64_t *composite, int64_t count) {
+        int64_t primes = 0;
+        for (int64_t word = 0; word * 64 < count; word++) {
+            uint64_t bits = ~composite[word];
+            if (count - word * 64 < 64)
+                bits &= ((uint64_t) 1 << (count - word * 64)) - 1;
+            primes += __builtin_popcountll(bits);
+        }
+        return primes;
+    }
+
+}
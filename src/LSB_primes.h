@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#ifndef IMAGE_STEGANOGRPAHY_LSB_PRIMES_H
+#define IMAGE_STEGANOGRPAHY_LSB_PRIMES_H
+
+#include <cstdint>
+#include <vector>
+
+namespace steg {
+
+    // The sieves keep a single bit for every odd number, the lazy
+    // generator sieves 32 Ki odd numbers (4 KiB) at a time, the whole
+    // list segments of 256 Ki odd numbers (32 KiB, fitting into the L1
+    // cache) split between the threads in runs of PRIME_GRAIN segments.
+#define PRIME_SEGMENT (32 * 1024)
+#define PRIME_LIST_SEGMENT (256 * 1024)
+#define PRIME_GRAIN 8
+
+    // All the primes below the limit, in increasing order, sieved by
+    // at most threads threads (0 meaning the number of cores).
+    std::vector<int64_t> primes(int64_t limit, int threads = 0);
+
+    // Number of the primes below the limit, sieved the same way as by
+    // primes(), but only counted, so no list of them is kept.
+    int64_t prime_count(int64_t limit, int threads = 0);
+
+    // Gives the primes below the limit one by one in increasing order,
+    // sieving a segment of numbers at a time only when the primes before
+    // it are used up, so the first few primes of a big limit are cheap.
+    class prime_generator {
+    public:
+        explicit prime_generator(int64_t limit);
+
+        // the next prime, -1 after the last one below the limit
+        int64_t next();
+
+    private:
+        int64_t limit;
+        std::vector<int64_t> base;      // odd primes up to sqrt(limit)
+        std::vector<uint64_t> segment;  // composite odd numbers low, low + 2, ...
+        int64_t low;
+        int64_t pos;
+        bool two;                       // 2 is still to be given
+    };
+
+    // A number of primes below the limit which is certainly not larger
+    // than the real count, without counting them.
+    int64_t prime_count_lower_bound(int64_t limit);
+
+}
+
+
+#endif //IMAGE_STEGANOGRPAHY_LSB_PRIMES_H
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+//                           The MIT License (MIT)
+//                    Copyright (c) 2017 Jokubas Liutkus
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+//===----------------------------------------------------------------------===//
+
+#include <string>
+#include <assert.h>
+#include <vector>
+#include "steganography.h"
+#include "LSB_kernels.h"
+#include "LSB_engine.h"
+#include "LSB_methods.h"
+#include "LSB_png.h"
+#include "CImg.h"
+
+using namespace cimg_library;
+
+
+namespace steg {
+
+
+    StegSession::StegSession(const std::string &name)
+            : name(name), image(new CImg<unsigned char>(name.c_str())) {}
+
+    StegSession::StegSession(const uint8_t *png, size_t size)
+            : image(new CImg<unsigned char>()) {
+        if (!png_buffer_to_image(png, size, *image))
+            image.reset(new CImg<unsigned char>());
+    }
+
+    StegSession::~StegSession() = default;
+
+    bool StegSession::is_empty() const {
+        return image->is_empty();
+    }
+
+    PixelView StegSession::view() const {
+        return image_view(*image);
+    }
+
+    void StegSession::encode(Method method,
+                             const std::string &message,
+                             const StegOptions &options) {
+        if (!valid_channels(view(), options.channels))
+            return;
+        if (is_list_method(method))
+            encode_list(view(), message, list_locations(method), method, options);
+        else
+            StegCoding::encode(view(), message, method, options);
+    }
+
+    std::string StegSession::decode(Method method, const StegOptions &options) {
+        if (!valid_channels(view(), options.channels))
+            return "";
+        if (!is_list_method(method))
+            return StegCoding::decode(view(), method, options);
+
+        std::string message;
+        message_output output(message);
+        if (!decode_list(view(), list_locations(method), method, options, output))
+            message.clear();
+        return message;
+    }
+
+    uint64_t StegSession::capacity(Method method, const StegOptions &options) {
+        if (!valid_channels(view(), options.channels))
+            return 0;
+        if (is_list_method(method))
+            return planes_capacity(list_locations(method).size(), options);
+        return StegCoding::capacity(view(), method, options);
+    }
+
+    void StegSession::save() const {
+        assert(!name.empty());
+        save(name);
+    }
+
+    void StegSession::save(const std::string &stego_image) const {
+        image->save(stego_image.c_str());
+    }
+
+    std::vector<uint8_t> StegSession::save_to_png_buffer() const {
+        std::vector<uint8_t> png;
+        if (!image_to_png_buffer(view(), png))
+            png.clear();
+        return png;
+    }
+
+    const std::vector<int64_t> &StegSession::list_locations(Method method) {
+        // the locations depend only on the image size, which never changes
+        auto found = locations.find(method);
+        if (found == locations.end())
+            found = locations.emplace(method, steg::list_locations(view(), method)).first;
+        return *found->second;
+    }
+
+    bool StegSession::is_list_method(Method method) {
+        // the spiral and magic square locations are computed as they
+        // are used, no list is needed
+        return method == Method::LSB_PRIME;
+    }
+
+}
@@ -26,14 +26,143 @@
 #define IMAGE_STEGANOGRPAHY_STEGANOGRAPHY_H
 
 #include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace cimg_library {
+    template<typename T>
+    struct CImg;
+}
 
 namespace steg {
 
-#define ENCODE_SIZE 64
 #define BIT_TO_BYTE 8
 #define RED 0
 #define GREEN 1
 #define BLUE 2
+#define ALPHA 3
+#define CHANNEL_MASK(channel) (1U << (channel))
+
+    /************************************************
+     * Encoding methods, one for each LSB_encode_xxx/LSB_decode_xxx
+     * pair of functions, used where the method is chosen at runtime.
+     *
+     * The method is stored in the header in front of every message, so
+     * a message is only decoded by the method it was encoded with.
+     ***********************************************/
+    enum class Method {
+        LSB,
+        LSB_ODD,
+        LSB_EVEN,
+        LSB_MAX,
+        LSB_MIN,
+        LSB_PRIME,
+        LSB_SPIRAL,
+        LSB_MAGIC_SQ
+    };
+
+    /************************************************
+     * Options of the encoding, the same options have to be used to
+     * decode the message.
+     *
+     * bits - number of the least significant bits of every sample
+     *        used to hide the message (1 to 4). More bits multiply the
+     *        capacity of the image and touch fewer pixels, at the cost
+     *        of a more visible distortion. By default 1 bit is used,
+     *        the same as all the LSB_encode_xxx functions do.
+     *
+     * channels - mask of the channels used to hide the message, e.g.
+     *        CHANNEL_MASK(RED) | CHANNEL_MASK(GREEN) | CHANNEL_MASK(BLUE).
+     *        The message fills the chosen channels one after another
+     *        (all of RED first, then GREEN, ...), so every selected
+     *        channel adds the capacity of the whole image. The LSB_MAX
+     *        and LSB_MIN methods never use RED, as the RED values
+     *        choose the pixels. By default only BLUE is used. With a
+     *        channel the image does not have nothing is encoded and the
+     *        decoded message is empty.
+     *
+     * checksum - store the CRC-32C of the message after it. Decoding
+     *        always checks the checksum when the message has one (no
+     *        matter the option) and gives an empty message if the
+     *        image was damaged. Takes 4 bytes of the capacity.
+     *
+     * threads - maximum number of threads encoding/decoding the message,
+     *        0 uses all the cores. Only large messages of the LSB method
+     *        with 1 bit in a single channel, and the search for the
+     *        pixels of the min/max methods in large images, are split
+     *        between threads, smaller ones are always processed by the
+     *        calling thread.
+     *
+     * row_pixels - number of pixels used in every row by the LSB_MAX
+     *        (LSB_MIN) method, the ones with the largest (smallest) RED
+     *        values, of equal values the ones more to the left. Their
+     *        samples are used from left to right. More pixels multiply
+     *        the capacity of the image. By default 1 pixel is used, at
+     *        most the whole row.
+     ***********************************************/
+    struct StegOptions {
+        int bits;
+        unsigned channels;
+        bool checksum;
+        int threads;
+        int row_pixels;
+
+        explicit StegOptions(int bits = 1,
+                             unsigned channels = CHANNEL_MASK(BLUE),
+                             bool checksum = false,
+                             int threads = 0,
+                             int row_pixels = 1)
+                : bits(bits), channels(channels), checksum(checksum),
+                  threads(threads), row_pixels(row_pixels) {}
+    };
+
+    /************************************************
+     * A view of an image which is already in memory, used by the
+     * in-memory encode/decode functions. Nothing is copied, the
+     * encode functions modify the pixels in place.
+     *
+     * The sample of channel c of the pixel (x, y) is located at
+     *
+     *      data[y * stride + x * pixel_step + c * channel_step]
+     *
+     * which covers both the interleaved layout of raw pixel buffers
+     * (RGBRGB...) and the planar layout used by CImg (RRR...GGG...BBB...).
+     *
+     * Image has to have at least 3 channels, as the data is hidden
+     * in the BLUE channel.
+     ***********************************************/
+    struct PixelView {
+        unsigned char *data;
+        int width;
+        int height;
+        int channels;
+        int64_t stride;
+        int64_t pixel_step;
+        int64_t channel_step;
+
+        // view of the interleaved pixels with stride bytes between rows
+        PixelView(unsigned char *data, int width, int height,
+                  int channels, int64_t stride)
+                : data(data), width(width), height(height), channels(channels),
+                  stride(stride), pixel_step(channels), channel_step(1) {}
+
+        // view of the planar pixels, each channel stored as a separate
+        // width x height plane one after the other (as in CImg)
+        static PixelView planar(unsigned char *data, int width, int height,
+                                int channels) {
+            PixelView view(data, width, height, channels, width);
+            view.pixel_step = 1;
+            view.channel_step = (int64_t) width * height;
+            return view;
+        }
+
+        unsigned char &operator()(int x, int y, int c) const {
+            return data[y * stride + x * pixel_step + c * channel_step];
+        }
+    };
 
     class StegCoding {
     public:
@@ -50,11 +179,16 @@ namespace steg {
          * all the data is at the moment hidden in the BLUE pixels
          * as it is the least sensitive to the human eye.
          *
-         * First of all the length of the message is encoded into first
-         * 64 pixels, this provides the max message size of 2^64 which
-         * is very unlikely to be exceeded (heh).
+         * First of all a header (magic, method, length of the message
+         * and a checksum, 48 bits for messages shorter than 128
+         * characters) is encoded into the first pixels, decoding
+         * an image without such a header gives an empty message.
          *
-         * At the moment image has to be of at least 64x64 size.
+         * The image has to have room for the header and, with the
+         * checksum option, the 4 byte checksum after the message: 48
+         * pixels (80 with the checksum) with 1 bit in a single channel,
+         * fewer with more bits or channels (see capacity). Nothing is
+         * encoded into a smaller image.
          *
          **************************************************
          *
@@ -119,13 +253,34 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB method was used or not.
+         * An image without a message of this method gives an empty
+         * string: the header of every message starts with a magic and
+         * the method and ends with a CRC-8 (see Method), so a clean
+         * image, or one encoded with another method, is rejected,
+         * nearly always after the first 16 bits. A message with a
+         * checksum (see StegOptions) is checked against it as well, a
+         * damaged one gives an empty string too.
          *         
          ***********************************************/
         static std::string LSB_decode(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode/LSB_decode working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode(cimg_library::CImg<unsigned char> &image,
+                               const std::string &message);
+
+        static void LSB_encode(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode(const PixelView &image);
+
 
         /************************************************
          * Encodes the message into the image which name is passed to 
@@ -140,11 +295,16 @@ namespace steg {
          * all the data is at the moment hidden in the BLUE pixels
          * as it is the least sensitive to the human eye.
          *
-         * First of all the length of the message is encoded into first
-         * 64 odd pixels of the image, this provides the max message 
-         * size of 2^64 which is very unlikely to be exceeded (heh).
+         * First of all a header (magic, method, length of the message
+         * and a checksum, 48 bits for messages shorter than 128
+         * characters) is encoded into the first odd pixels, decoding
+         * an image without such a header gives an empty message.
          *
-         * At the moment image has to be of at least 64x64 size.
+         * The image has to have room for the header and, with the
+         * checksum option, the 4 byte checksum after the message: 48
+         * odd pixels (80 with the checksum) with 1 bit in a single
+         * channel, fewer with more bits or channels (see capacity).
+         * Nothing is encoded into a smaller image.
          * 
          **************************************************
          *
@@ -211,13 +371,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_odd(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_odd/LSB_decode_odd working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_odd(cimg_library::CImg<unsigned char> &image,
+                                   const std::string &message);
+
+        static void LSB_encode_odd(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_odd(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_odd(const PixelView &image);
+
 
         /************************************************
          * Encodes the message into the image which name is passed to 
@@ -232,11 +408,16 @@ namespace steg {
          * all the data is at the moment hidden in the BLUE pixels
          * as it is the least sensitive to the human eye.
          *
-         * First of all the length of the message is encoded into first
-         * 64 even pixels of the image, this provides the max message 
-         * size of 2^64 which is very unlikely to be exceeded (heh).
+         * First of all a header (magic, method, length of the message
+         * and a checksum, 48 bits for messages shorter than 128
+         * characters) is encoded into the first even pixels, decoding
+         * an image without such a header gives an empty message.
          *
-         * At the moment image has to be of at least 64x64 size.
+         * The image has to have room for the header and, with the
+         * checksum option, the 4 byte checksum after the message: 48
+         * even pixels (80 with the checksum) with 1 bit in a single
+         * channel, fewer with more bits or channels (see capacity).
+         * Nothing is encoded into a smaller image.
          * 
          **************************************************
          *
@@ -304,13 +485,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_even(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_even/LSB_decode_even working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_even(cimg_library::CImg<unsigned char> &image,
+                                    const std::string &message);
+
+        static void LSB_encode_even(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_even(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_even(const PixelView &image);
+
         /************************************************
         * Encodes the message into the image which name is passed to
         * the function using the LSB max method where the largest pixel in a row
@@ -324,11 +521,17 @@ namespace steg {
         * all the data is at the moment hidden in the BLUE pixels
         * as it is the least sensitive to the human eye.
         *
-        * First of all the length of the message is encoded into first
-        * 64 rows, this provides the max message size of 2^64 which
-        * is very unlikely to be exceeded (heh).
+        * First of all a header (magic, method, length of the message
+        * and a checksum, 48 bits for messages shorter than 128
+        * characters) is encoded into the first rows, decoding
+        * an image without such a header gives an empty message.
         *
-        * At the moment image has to be of at least 64x64 size.
+        * The image has to have room for the header and, with the
+        * checksum option, the 4 byte checksum after the message: 48
+        * rows (80 with the checksum) with 1 pixel in every row and 1
+        * bit in a single channel, fewer with more row_pixels, bits or
+        * channels (see capacity). Nothing is encoded into a smaller
+        * image.
         *
         **************************************************
         *
@@ -397,13 +600,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB_max method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_max(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_max/LSB_decode_max working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_max(cimg_library::CImg<unsigned char> &image,
+                                   const std::string &message);
+
+        static void LSB_encode_max(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_max(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_max(const PixelView &image);
+
         /************************************************
          * Encodes the message into the image which name is passed to 
          * the function using the LSB min method where the smallest pixel in a row
@@ -417,11 +636,17 @@ namespace steg {
          * all the data is at the moment hidden in the BLUE pixels
          * as it is the least sensitive to the human eye.
          *
-         * First of all the length of the message is encoded into first
-         * 64 rows, this provides the max message size of 2^64 which
-         * is very unlikely to be exceeded (heh).
+         * First of all a header (magic, method, length of the message
+         * and a checksum, 48 bits for messages shorter than 128
+         * characters) is encoded into the first rows, decoding
+         * an image without such a header gives an empty message.
          *
-         * At the moment image has to be of at least 64x64 size.
+         * The image has to have room for the header and, with the
+         * checksum option, the 4 byte checksum after the message: 48
+         * rows (80 with the checksum) with 1 pixel in every row and 1
+         * bit in a single channel, fewer with more row_pixels, bits or
+         * channels (see capacity). Nothing is encoded into a smaller
+         * image.
          *
          **************************************************
          *
@@ -490,13 +715,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB_min method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_min(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_min/LSB_decode_min working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_min(cimg_library::CImg<unsigned char> &image,
+                                   const std::string &message);
+
+        static void LSB_encode_min(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_min(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_min(const PixelView &image);
+
         /************************************************
         * Encodes the message into the image which name is passed to
         * the function using the LSB prime method where each bit of the message
@@ -506,11 +747,16 @@ namespace steg {
         * all the data is at the moment hidden in the BLUE pixels
         * as it is the least sensitive to the human eye.
         *
-        * First of all the length of the message is encoded into first
-        * 64 locations, this provides the max message size of 2^64 which
-        * is very unlikely to be exceeded (heh).
+        * First of all a header (magic, method, length of the message
+        * and a checksum, 48 bits for messages shorter than 128
+        * characters) is encoded into the first locations, decoding
+        * an image without such a header gives an empty message.
         *
-        * At the moment image has to be of at least 64x64 size.
+        * The image has to have room for the header and, with the
+        * checksum option, the 4 byte checksum after the message: 48
+        * prime locations (80 with the checksum) with 1 bit in a single
+        * channel, fewer with more bits or channels (see capacity).
+        * Nothing is encoded into a smaller image.
         *
         **************************************************
         *
@@ -580,13 +826,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB_prime method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_prime(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_prime/LSB_decode_prime working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_prime(cimg_library::CImg<unsigned char> &image,
+                                     const std::string &message);
+
+        static void LSB_encode_prime(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_prime(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_prime(const PixelView &image);
+
         /************************************************
         * Encodes the message into the image which name is passed to
         * the function using the LSB spiral matrix method where each
@@ -597,11 +859,16 @@ namespace steg {
         * all the data is at the moment hidden in the BLUE pixels
         * as it is the least sensitive to the human eye.
         *
-        * First of all the length of the message is encoded into first
-        * 64 locations, this provides the max message size of 2^64 which
-        * is very unlikely to be exceeded (heh).
+        * First of all a header (magic, method, length of the message
+        * and a checksum, 48 bits for messages shorter than 128
+        * characters) is encoded into the first locations, decoding
+        * an image without such a header gives an empty message.
         *
-        * At the moment image has to be of at least 64x64 size.
+        * The image has to have room for the header and, with the
+        * checksum option, the 4 byte checksum after the message: 48
+        * pixels of the spiral (80 with the checksum) with 1 bit in a
+        * single channel, fewer with more bits or channels (see
+        * capacity). Nothing is encoded into a smaller image.
         *
         **************************************************
         *
@@ -616,21 +883,22 @@ namespace steg {
         * this yields 01001100 in binary.
         *
         * We are going to encode each bit in each spiral matrix located pixel
-        * starting from top left and working our way to the right and then
-        * down the rows.
+        * starting from the bottom left and working our way along the
+        * diagonals to the top right.
         *
-        * First we generate our spiral matrix i.e.
+        * First we generate our spiral matrix (starting in the middle of
+        * the image, which can be of any size) i.e.
         *
-        *        4 5 6
-        *        3 0 7
-        *        2 1 8
+        *        6 5 4
+        *        7 0 3
+        *        8 1 2
         *
         * and the list collected will be:
-        * 2 3 1 4 0 8 5 7 6 (pattern of collecting
+        * 8 7 1 6 0 2 5 3 4 (pattern of collecting
         * the elements can be seen from the example)
         * More about the method can be found in the implementation source file.
         *
-        * So our first bit will go into location 2, second to 3,
+        * So our first bit will go into location 8, second to 7,
         * third into 1 and so on.
         *
         *
@@ -645,17 +913,17 @@ namespace steg {
         *                   [0]1001100
         *
         * First bit in the message is [0] and the first location is
-        * 2 therefore pixel 0 (00000000) will be encoded.
+        * 8 therefore pixel 8 (00000101) will be encoded.
         * We replace the LSB of the pixel and this yields the
-        * 0000000[0] pixel with encoded bit in the brackets
+        * 0000010[0] pixel with encoded bit in the brackets
         *
         * replacing the second bit in the message 0[1]001100
-        * yields the pixel in location 3 (i.e. 100)
-        * to become  0110010[1], and so on, until we get the image:
+        * yields the pixel in location 7 (i.e. 12)
+        * to become  0000110[1], and so on, until we get the image:
         *
-        *       1100100[1]  1100011[0]  0000000[0]
-        *       0110010[1]  0000111[0]  0000101[0]
-        *       01100011    0000110[0]  0000010[1]
+        *       1100100[1]  1100011[0]  0000000[1]
+        *       0110010[0]  00001111    0000101[0]
+        *       0110001[0]  0000110[1]  0000010[0]
         *
         ***********************************************/
         static void LSB_encode_spiral(const std::string &name, const std::string &message);
@@ -684,13 +952,29 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB_spiral method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_spiral(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_spiral/LSB_decode_spiral working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_spiral(cimg_library::CImg<unsigned char> &image,
+                                      const std::string &message);
+
+        static void LSB_encode_spiral(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_spiral(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_spiral(const PixelView &image);
+
 
         /************************************************
         * Encodes the message into the image which name is passed to
@@ -702,11 +986,16 @@ namespace steg {
         * all the data is at the moment hidden in the BLUE pixels
         * as it is the least sensitive to the human eye.
         *
-        * First of all the length of the message is encoded into first
-        * 64 locations, this provides the max message size of 2^64 which
-        * is very unlikely to be exceeded (heh).
+        * First of all a header (magic, method, length of the message
+        * and a checksum, 48 bits for messages shorter than 128
+        * characters) is encoded into the first locations, decoding
+        * an image without such a header gives an empty message.
         *
-        * At the moment image has to be of at least 64x64 size.
+        * The image has to have room for the header and, with the
+        * checksum option, the 4 byte checksum after the message: 48
+        * pixels of the magic square (80 with the checksum) with 1 bit
+        * in a single channel, fewer with more bits or channels (see
+        * capacity). Nothing is encoded into a smaller image.
         *
         **************************************************
         *
@@ -724,18 +1013,23 @@ namespace steg {
         * starting from top left and working our way to the right and then
         * down the rows.
         *
-        * First we generate our spiral matrix i.e.
+        * First we generate our magic square, the smallest one of odd
+        * size which has more cells than the image has pixels (5x5
+        * for our 9 pixels), numbered from 0:
         *
-        *   4  9  2 
-        *   3  5  7 
-        *   8  1  6 
+        *   10 17 24  1  8
+        *    9 11 18 20  2
+        *    3  5 12 19 21
+        *   22  4  6 13 15
+        *   16 23  0  7 14
         *
         * and the list collected will be:
-        * 4 9 2 3 5 7 8 1 6 (pattern of collecting
-        * the elements can be seen from the example)
+        * 1 8 2 3 5 4 6 0 7 (the numbers read row by row, skipping
+        * the ones which are not locations of the image, so every
+        * pixel is used exactly once)
         * More about the method can be found in the implementation source file.
         *
-        * So our first bit will go into location 4, second to 9,
+        * So our first bit will go into location 1, second to 8,
         * third into 2 and so on.
         *
         *
@@ -750,17 +1044,17 @@ namespace steg {
         *                   [0]1001100
         *
         * First bit in the message is [0] and the first location is
-        * 4 therefore pixel 15 (00001111) will be encoded.
+        * 1 therefore pixel 198 (11000110) will be encoded.
         * We replace the LSB of the pixel and this yields the
-        * 0000111[0] pixel with encoded bit in the brackets
+        * 1100011[0] pixel with encoded bit in the brackets
         *
         * replacing the second bit in the message 0[1]001100
-        * yields the pixel in location 9 (there is not location 9 in our example)
-        * to be modified, and so on, until we get the image:
+        * yields the pixel in location 8 (00000101) to be modified,
+        * and so on, until we get the image:
         *
-        *       11001000    1100011[0]  0000000[0]
-        *       0110010[0]  0000111[0]  0000101[1]
-        *       01100011    0000110[1]  0000010[0]
+        *       1100100[0]  1100011[0]  0000000[0]
+        *       0110010[0]  0000111[1]  0000101[1]
+        *       0110001[0]  00001100    0000010[1]
         *
         ***********************************************/
         static void LSB_encode_magic_sq(const std::string &name, const std::string &message);
@@ -790,13 +1084,281 @@ namespace steg {
          *
          * The message is retrieved from the image and returned as a string.
          * 
-         * If random image is passed the are no checks done whether the
-         * encoding was used, and therefore it is impossible to determine
-         * if the LSB_magic_square method was used or not.
+         * Same checks of the header as in LSB_decode, an image
+         * without a message of this method gives an empty string.
          *         
          ***********************************************/
         static std::string LSB_decode_magic_sq(const std::string &name);
 
+        /************************************************
+         *
+         * Same functions as the LSB_encode_magic_sq/LSB_decode_magic_sq working on an image
+         * which is already in memory, either CImg image or raw pixels
+         * given by PixelView. Encoding modifies the image in place,
+         * nothing is read from or written to the disk.
+         *
+         ***********************************************/
+        static void LSB_encode_magic_sq(cimg_library::CImg<unsigned char> &image,
+                                        const std::string &message);
+
+        static void LSB_encode_magic_sq(const PixelView &image, const std::string &message);
+
+        static std::string LSB_decode_magic_sq(const cimg_library::CImg<unsigned char> &image);
+
+        static std::string LSB_decode_magic_sq(const PixelView &image);
+
+        /************************************************
+         *
+         * Encodes/decodes the message using the given method, the same as
+         * calling the corresponding LSB_encode_xxx/LSB_decode_xxx function
+         * on the image in memory, with the given options.
+         *
+         ***********************************************/
+        static void encode(const PixelView &image,
+                           const std::string &message,
+                           Method method,
+                           const StegOptions &options = StegOptions());
+
+        static std::string decode(const PixelView &image,
+                                  Method method,
+                                  const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Same as encode/decode above for binary messages (which might
+         * hold NUL bytes) in the memory of the caller, which are neither
+         * copied into nor returned as a string.
+         *
+         * encode hides the size bytes of payload.
+         *
+         * decode writes the message straight into payload, which can
+         * hold size bytes, and returns the length of the message, 0 if
+         * there is none (payload might have been written to even then,
+         * e.g. when the checksum did not match). A message longer than
+         * size is not decoded, but its length is still returned, so the
+         * caller can tell that a larger buffer is needed (capacity gives
+         * the length of the longest message of the image).
+         ***********************************************/
+        static void encode(const PixelView &image,
+                           const uint8_t *payload,
+                           size_t size,
+                           Method method,
+                           const StegOptions &options = StegOptions());
+
+        static uint64_t decode(const PixelView &image,
+                               uint8_t *payload,
+                               size_t size,
+                               Method method,
+                               const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Returns the number of message bytes which can be encoded into
+         * the image using the given method, longer messages are cut
+         * to this length when encoded.
+         ***********************************************/
+        static uint64_t capacity(const PixelView &image,
+                                 Method method,
+                                 const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Same function as the capacity above, for the PNG image file
+         * which name is given. Only the headers of the file are read,
+         * the pixels are not decoded, so many candidate images can be
+         * checked cheaply. The channels are counted as the image is
+         * loaded for encoding (gray expanded to RGB, alpha added by a
+         * tRNS chunk). Returns 0 if the file is not a PNG image or does
+         * not have the channels of the options.
+         ***********************************************/
+        static uint64_t capacity(const std::string &name,
+                                 Method method,
+                                 const StegOptions &options = StegOptions());
+
+        /************************************************
+         * The locations used by the prime method depend only on the
+         * size of the image, so they are computed once and kept in a
+         * cache shared by all the threads, and the following images of
+         * the same size reuse them. The least recently used locations
+         * are dropped once the cache takes more than the limit (64 MiB
+         * by default) of memory.
+         ***********************************************/
+        static void set_location_cache_limit(uint64_t bytes);
+
+        /************************************************
+         * Writes the locations in the cache into the file, which
+         * load_location_cache of another process (e.g. a new worker)
+         * reads to start with the locations already computed.
+         *
+         * Returns false if the file could not be written/read or is not
+         * a valid cache file (which only holds prime method locations),
+         * in which case nothing is loaded.
+         ***********************************************/
+        static bool save_location_cache(const std::string &file);
+
+        static bool load_location_cache(const std::string &file);
+
+        /************************************************
+         * Encodes the message into the PNG image given as the bytes of
+         * the PNG file (png, size) using the given method, and returns
+         * the bytes of the PNG stego image. Nothing is read from or written
+         * to the disk, the image is decoded and encoded in memory.
+         *
+         * Palette and grayscale images are expanded to RGB, 16 bit
+         * images are reduced to 8 bits per sample.
+         *
+         * Empty buffer is returned if png is not a valid PNG image, does
+         * not have the channels of the options or is too small for the
+         * header of the method (capacity is 0).
+         ***********************************************/
+        static std::vector<uint8_t> encode_to_png_buffer(const uint8_t *png,
+                                                         size_t size,
+                                                         const std::string &message,
+                                                         Method method = Method::LSB,
+                                                         const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Decodes the message from the PNG image given as the bytes of
+         * the PNG file (png, size) using the given method.
+         * This is the opposite of encode_to_png_buffer.
+         *
+         * Empty string is returned if png is not a valid PNG image.
+         ***********************************************/
+        static std::string decode_from_png_buffer(const uint8_t *png,
+                                                  size_t size,
+                                                  Method method = Method::LSB,
+                                                  const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Encodes the message into the PNG image file name and writes
+         * the stego image into the PNG file stego_image (which can be
+         * the same file), reading, encoding and writing one row at a
+         * time, so that even huge images take only a few rows of memory.
+         * The stego image is written into a temporary file next to
+         * stego_image, which replaces stego_image only when the whole
+         * image is written, so a failure leaves all the files as they
+         * were.
+         *
+         * Only the methods which go through the pixels row by row can be
+         * used this way: LSB, LSB_ODD and LSB_EVEN. The stego image is
+         * the same as the one encode_to_png_buffer gives, 8 bit RGB(A),
+         * and is decoded by the usual functions.
+         *
+         * Returns false if the method can not be streamed, the image is
+         * not a non-interlaced PNG (or does not have the channels of the
+         * options) or could not be written.
+         ***********************************************/
+        static bool encode_png_stream(const std::string &name,
+                                      const std::string &message,
+                                      const std::string &stego_image,
+                                      Method method = Method::LSB,
+                                      const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Decodes the message of the PNG image file name encoded with
+         * the LSB, LSB_ODD or LSB_EVEN method, decompressing the rows
+         * one at a time and stopping right after the last row holding
+         * the message, so a short message in a big image is decoded
+         * without inflating most of the file.
+         *
+         * LSB_decode, LSB_decode_odd and LSB_decode_even of a PNG file
+         * decode it this way too.
+         *
+         * Empty string is returned if the method can not be streamed or
+         * the image is not a non-interlaced PNG.
+         ***********************************************/
+        static std::string decode_png_stream(const std::string &name,
+                                             Method method = Method::LSB,
+                                             const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Encodes the message into the uncompressed image file name
+         * (binary PPM or 24/32 bit BMP) in place, using the given
+         * method. The file is mapped into memory instead of being
+         * loaded and saved, so only the samples holding the message are
+         * changed and only the pages with them are written back, which
+         * makes encoding a short message into a big image cheap.
+         *
+         * The image can be decoded by decode_mapped or by any of the
+         * decode functions loading the file.
+         *
+         * Returns false if the file can not be mapped, is not one of
+         * the supported formats, does not have the channels of the
+         * options or is too small for the header of the method
+         * (capacity is 0), the file is left untouched then.
+         ***********************************************/
+        static bool encode_mapped(const std::string &name,
+                                  const std::string &message,
+                                  Method method = Method::LSB,
+                                  const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Decodes the message of the uncompressed image file name
+         * (binary PPM or 24/32 bit BMP) encoded with the given method,
+         * reading the pixels straight from the file mapped into memory.
+         *
+         * Empty string is returned if the file can not be mapped or is
+         * not one of the supported formats.
+         ***********************************************/
+        static std::string decode_mapped(const std::string &name,
+                                         Method method = Method::LSB,
+                                         const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Encodes several independent messages into the image at once,
+         * each into a lane of its own: with n messages lane k is made
+         * of the pixels k, k + n, k + 2n, ... (counting the pixels row
+         * by row). The lanes are encoded by separate threads when the
+         * messages are large (see StegOptions::threads).
+         *
+         * Two messages give the same image as LSB_encode_even of the
+         * first one and LSB_encode_odd of the second one, so they can
+         * also be decoded by LSB_decode_even/LSB_decode_odd. A single
+         * message is the same as the LSB method.
+         *
+         * With three or more messages the header of every lane is the
+         * one of the LSB method, the number of the lanes and the lane
+         * are not stored. Decoding has to use the same number of lanes:
+         * a wrong one reads other pixels, which nearly always give no
+         * valid header, but it can not be told apart from a plain LSB
+         * stream over those pixels.
+         *
+         * Every message is cut to the capacity of its lane, given by
+         * lane_capacity. Nothing is encoded and false is returned if
+         * the capacity of any lane is 0 (the header does not fit or the
+         * image does not have the channels of the options), the file
+         * version then does not write the stego image at all. It reads
+         * the image once and writes the stego image (which can be the
+         * same file) once.
+         ***********************************************/
+        static bool encode_lanes(const std::string &name,
+                                 const std::vector<std::string> &messages,
+                                 const std::string &stego_image,
+                                 const StegOptions &options = StegOptions());
+
+        static bool encode_lanes(const PixelView &image,
+                                 const std::vector<std::string> &messages,
+                                 const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Decodes the messages of all the lanes of the image encoded
+         * by encode_lanes with lanes messages, an empty message for
+         * every lane without one.
+         ***********************************************/
+        static std::vector<std::string> decode_lanes(const std::string &name,
+                                                     int lanes,
+                                                     const StegOptions &options = StegOptions());
+
+        static std::vector<std::string> decode_lanes(const PixelView &image,
+                                                     int lanes,
+                                                     const StegOptions &options = StegOptions());
+
+        /************************************************
+         * Returns the number of message bytes which can be encoded into
+         * the lane (0 to lanes - 1) of the image split into lanes lanes.
+         ***********************************************/
+        static uint64_t lane_capacity(const PixelView &image,
+                                      int lanes,
+                                      int lane,
+                                      const StegOptions &options = StegOptions());
+
         static void encode_binary_image(const std::string &name,
                                         const std::string &binary_image);
 
@@ -806,6 +1368,62 @@ namespace steg {
 
     };
 
+
+    /************************************************
+     * Keeps a single image loaded in memory to run several encode/decode
+     * calls on it, e.g. encoding a message and then verifying it by
+     * decoding, without reading and decoding the image file again for
+     * every call as the StegCoding functions do.
+     *
+     * The locations used by the prime method depend only on the size
+     * of the image, therefore they are taken once (from the location
+     * cache) and kept by the session for all the following calls.
+     *
+     * Nothing is written to the disk until save() is called.
+     ***********************************************/
+    class StegSession {
+    public:
+
+        // loads the image from the file
+        explicit StegSession(const std::string &name);
+
+        // loads the image from the bytes of the PNG file, check
+        // is_empty() to find out if png was a valid PNG image
+        StegSession(const uint8_t *png, size_t size);
+
+        ~StegSession();
+
+        bool is_empty() const;
+
+        PixelView view() const;
+
+        void encode(Method method, const std::string &message,
+                    const StegOptions &options = StegOptions());
+
+        std::string decode(Method method,
+                           const StegOptions &options = StegOptions());
+
+        uint64_t capacity(Method method,
+                          const StegOptions &options = StegOptions());
+
+        // saves the image into the file it was loaded from
+        void save() const;
+
+        void save(const std::string &stego_image) const;
+
+        // the image encoded as PNG file bytes
+        std::vector<uint8_t> save_to_png_buffer() const;
+
+    private:
+        std::string name;
+        std::unique_ptr<cimg_library::CImg<unsigned char>> image;
+        std::map<Method, std::shared_ptr<const std::vector<int64_t>>> locations;
+
+        const std::vector<int64_t> &list_locations(Method method);
+
+        static bool is_list_method(Method method);
+    };
+
 }
 
 